@@ -0,0 +1,419 @@
+/*
+OBS Starter Plugin - Executable Inspection Implementation
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#include "binary-info.h"
+
+#ifndef _WIN32
+
+#include <mutex>
+#include <fcntl.h>
+#include <glob.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <elf.h>
+#endif
+
+#ifdef __APPLE__
+#include <libkern/OSByteOrder.h>
+#include <mach-o/fat.h>
+#include <mach-o/loader.h>
+#include <mach/machine.h>
+#endif
+
+// Guards against malformed or hostile files
+static const size_t MAX_ELF_PHDRS = 256;
+static const size_t MAX_ELF_DYNAMIC = 4096;
+static const size_t MAX_ELF_STRTAB = 1 << 20;
+
+static bool read_at(int fd, void *buffer, size_t length, off_t offset)
+{
+    return pread(fd, buffer, length, offset) == (ssize_t)length;
+}
+
+static std::string directory_of(const std::string &path)
+{
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+static void split_paths(const std::string &list, const std::string &origin, std::vector<std::string> &out)
+{
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(':', start);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string entry = list.substr(start, end - start);
+        for (const char *token : {"${ORIGIN}", "$ORIGIN"}) {
+            size_t pos;
+            while ((pos = entry.find(token)) != std::string::npos)
+                entry.replace(pos, strlen(token), origin);
+        }
+        if (!entry.empty())
+            out.push_back(entry);
+        start = end + 1;
+    }
+}
+
+// Looks name up in $PATH, as /usr/bin/env does for "#!/usr/bin/env python3"
+static std::string find_in_path(const std::string &name)
+{
+    const char *path_env = getenv("PATH");
+    std::vector<std::string> dirs;
+    split_paths(path_env ? path_env : "/usr/local/bin:/usr/bin:/bin", std::string(), dirs);
+
+    for (const std::string &dir : dirs) {
+        std::string candidate = dir + "/" + name;
+        if (access(candidate.c_str(), X_OK) == 0)
+            return candidate;
+    }
+    return std::string();
+}
+
+static void parse_shebang(const char *header, size_t length, BinaryInfo &info)
+{
+    info.is_script = true;
+
+    std::string line(header + 2, length - 2);
+    line = line.substr(0, line.find_first_of("\r\n"));
+
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos)
+        return;
+    size_t end = line.find_first_of(" \t", start);
+    info.interpreter = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+    const std::string &interpreter = info.interpreter;
+    if (end == std::string::npos || interpreter.size() < 4 ||
+        interpreter.compare(interpreter.size() - 4, 4, "/env") != 0)
+        return;
+
+    size_t arg_start = line.find_first_not_of(" \t", end);
+    if (arg_start == std::string::npos || line[arg_start] == '-')
+        return;
+    size_t arg_end = line.find_first_of(" \t", arg_start);
+    info.program = line.substr(arg_start, arg_end == std::string::npos ? std::string::npos : arg_end - arg_start);
+    info.program_path = find_in_path(info.program);
+}
+
+#ifdef __linux__
+
+static void parse_ld_so_conf(const std::string &conf_path, std::vector<std::string> &dirs, int depth)
+{
+    FILE *file = fopen(conf_path.c_str(), "r");
+    if (!file)
+        return;
+
+    char line[PATH_MAX];
+    while (fgets(line, sizeof(line), file)) {
+        std::string entry(line);
+        entry = entry.substr(0, entry.find_first_of("#\r\n"));
+        size_t start = entry.find_first_not_of(" \t");
+        if (start == std::string::npos)
+            continue;
+        entry = entry.substr(start, entry.find_last_not_of(" \t") - start + 1);
+
+        if (entry.compare(0, 8, "include ") == 0) {
+            if (depth > 4)
+                continue;
+            std::string pattern = entry.substr(entry.find_first_not_of(" \t", 8));
+            if (pattern[0] != '/')
+                pattern = directory_of(conf_path) + "/" + pattern;
+
+            glob_t matches;
+            if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+                for (size_t i = 0; i < matches.gl_pathc; ++i)
+                    parse_ld_so_conf(matches.gl_pathv[i], dirs, depth + 1);
+            }
+            globfree(&matches);
+        } else if (entry[0] == '/') {
+            dirs.push_back(entry);
+        }
+    }
+    fclose(file);
+}
+
+static const std::vector<std::string> &system_library_dirs()
+{
+    static std::once_flag once;
+    static std::vector<std::string> dirs;
+    std::call_once(once, [] {
+        parse_ld_so_conf("/etc/ld.so.conf", dirs, 0);
+        for (const char *dir : {"/lib64", "/usr/lib64", "/lib", "/usr/lib"})
+            dirs.push_back(dir);
+    });
+    return dirs;
+}
+
+// Class and machine of OBS itself, binaries must match to be executable
+static void host_elf_arch(unsigned char &elf_class, uint16_t &machine)
+{
+    static std::once_flag once;
+    static unsigned char host_class = 0;
+    static uint16_t host_machine = 0;
+    std::call_once(once, [] {
+        int fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+        unsigned char ident[EI_NIDENT + 4] = {};
+        if (fd >= 0 && read_at(fd, ident, sizeof(ident), 0)) {
+            host_class = ident[EI_CLASS];
+            memcpy(&host_machine, ident + EI_NIDENT + 2, 2);
+        }
+        if (fd >= 0)
+            close(fd);
+    });
+    elf_class = host_class;
+    machine = host_machine;
+}
+
+static const char *elf_machine_name(uint16_t machine)
+{
+    switch (machine) {
+    case EM_386:
+        return "x86";
+    case EM_X86_64:
+        return "x86-64";
+    case EM_ARM:
+        return "ARM";
+    case EM_AARCH64:
+        return "AArch64";
+    case EM_RISCV:
+        return "RISC-V";
+    case EM_PPC64:
+        return "PowerPC64";
+    default:
+        return "unknown machine";
+    }
+}
+
+// The loader skips libraries built for another class or machine, so do we
+static bool elf_matches(const std::string &path, unsigned char elf_class, uint16_t machine)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    unsigned char ident[EI_NIDENT + 4] = {};
+    bool matches = read_at(fd, ident, sizeof(ident), 0) && memcmp(ident, ELFMAG, SELFMAG) == 0 &&
+                   ident[EI_CLASS] == elf_class && memcmp(ident + EI_NIDENT + 2, &machine, 2) == 0;
+    close(fd);
+    return matches;
+}
+
+template<typename Ehdr, typename Phdr, typename Dyn>
+static void parse_elf(int fd, const std::string &path, BinaryInfo &info)
+{
+    Ehdr ehdr;
+    if (!read_at(fd, &ehdr, sizeof(ehdr), 0))
+        return;
+
+    unsigned char elf_class = sizeof(Ehdr) == sizeof(Elf64_Ehdr) ? ELFCLASS64 : ELFCLASS32;
+    unsigned char host_class;
+    uint16_t host_machine;
+    host_elf_arch(host_class, host_machine);
+    info.is_native = true;
+    info.arch = std::string(elf_class == ELFCLASS64 ? "ELF64 " : "ELF32 ") + elf_machine_name(ehdr.e_machine);
+    info.arch_matches = host_class == 0 || (elf_class == host_class && ehdr.e_machine == host_machine);
+
+    if (ehdr.e_phentsize != sizeof(Phdr) || ehdr.e_phnum > MAX_ELF_PHDRS)
+        return;
+
+    std::vector<Phdr> phdrs(ehdr.e_phnum);
+    if (!read_at(fd, phdrs.data(), phdrs.size() * sizeof(Phdr), (off_t)ehdr.e_phoff))
+        return;
+
+    std::vector<Dyn> dynamic;
+    for (const Phdr &phdr : phdrs) {
+        if (phdr.p_type == PT_INTERP && phdr.p_filesz > 1 && phdr.p_filesz < PATH_MAX) {
+            std::string interpreter(phdr.p_filesz, '\0');
+            if (read_at(fd, &interpreter[0], interpreter.size(), (off_t)phdr.p_offset))
+                info.interpreter = interpreter.c_str();
+        } else if (phdr.p_type == PT_DYNAMIC) {
+            size_t count = phdr.p_filesz / sizeof(Dyn);
+            if (count > MAX_ELF_DYNAMIC)
+                return;
+            dynamic.resize(count);
+            if (!read_at(fd, dynamic.data(), count * sizeof(Dyn), (off_t)phdr.p_offset))
+                return;
+        }
+    }
+
+    uint64_t strtab_addr = 0, strtab_size = 0;
+    std::vector<uint64_t> needed;
+    uint64_t rpath = UINT64_MAX, runpath = UINT64_MAX;
+    for (const Dyn &dyn : dynamic) {
+        if (dyn.d_tag == DT_NULL)
+            break;
+        switch (dyn.d_tag) {
+        case DT_STRTAB:
+            strtab_addr = dyn.d_un.d_ptr;
+            break;
+        case DT_STRSZ:
+            strtab_size = dyn.d_un.d_val;
+            break;
+        case DT_NEEDED:
+            needed.push_back(dyn.d_un.d_val);
+            break;
+        case DT_RPATH:
+            rpath = dyn.d_un.d_val;
+            break;
+        case DT_RUNPATH:
+            runpath = dyn.d_un.d_val;
+            break;
+        }
+    }
+    if (needed.empty() || strtab_size == 0 || strtab_size > MAX_ELF_STRTAB)
+        return;
+
+    // DT_STRTAB is a virtual address, map it back to a file offset
+    off_t strtab_offset = -1;
+    for (const Phdr &phdr : phdrs) {
+        if (phdr.p_type == PT_LOAD && strtab_addr >= phdr.p_vaddr && strtab_addr < phdr.p_vaddr + phdr.p_filesz) {
+            strtab_offset = (off_t)(strtab_addr - phdr.p_vaddr + phdr.p_offset);
+            break;
+        }
+    }
+    std::string strtab(strtab_size, '\0');
+    if (strtab_offset < 0 || !read_at(fd, &strtab[0], strtab.size(), strtab_offset))
+        return;
+    strtab.push_back('\0');
+
+    auto string_at = [&strtab](uint64_t offset) {
+        return offset < strtab.size() ? std::string(strtab.c_str() + offset) : std::string();
+    };
+
+    // Same order as ld.so: DT_RPATH (without DT_RUNPATH), LD_LIBRARY_PATH, DT_RUNPATH, system dirs
+    std::string origin = directory_of(path);
+    std::vector<std::string> search;
+    if (rpath != UINT64_MAX && runpath == UINT64_MAX)
+        split_paths(string_at(rpath), origin, search);
+    const char *library_path = getenv("LD_LIBRARY_PATH");
+    if (library_path)
+        split_paths(library_path, origin, search);
+    if (runpath != UINT64_MAX)
+        split_paths(string_at(runpath), origin, search);
+    const std::vector<std::string> &system_dirs = system_library_dirs();
+    search.insert(search.end(), system_dirs.begin(), system_dirs.end());
+
+    for (uint64_t offset : needed) {
+        std::string name = string_at(offset);
+        if (name.empty())
+            continue;
+        if (name.find('/') != std::string::npos) {
+            if (access(name.c_str(), R_OK) == 0)
+                info.libraries.push_back(name);
+            else
+                info.missing_libraries.push_back(name);
+            continue;
+        }
+
+        bool found = false;
+        for (const std::string &dir : search) {
+            std::string candidate = dir + "/" + name;
+            if (elf_matches(candidate, elf_class, ehdr.e_machine)) {
+                info.libraries.push_back(candidate);
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            info.missing_libraries.push_back(name);
+    }
+}
+
+#endif
+
+#ifdef __APPLE__
+
+static cpu_type_t host_cpu_type()
+{
+#if defined(__aarch64__) || defined(__arm64__)
+    return CPU_TYPE_ARM64;
+#else
+    return CPU_TYPE_X86_64;
+#endif
+}
+
+static void parse_mach_o(int fd, const unsigned char *header, size_t length, BinaryInfo &info)
+{
+    uint32_t magic;
+    memcpy(&magic, header, sizeof(magic));
+
+    if (magic == MH_MAGIC_64 && length >= sizeof(mach_header_64)) {
+        mach_header_64 mach;
+        memcpy(&mach, header, sizeof(mach));
+        info.is_native = true;
+        info.arch = mach.cputype == CPU_TYPE_ARM64 ? "Mach-O arm64" : "Mach-O x86_64";
+        info.arch_matches = mach.cputype == host_cpu_type();
+        return;
+    }
+
+    // Universal binaries are big-endian and usable if any slice matches
+    if (OSSwapBigToHostInt32(magic) != FAT_MAGIC || length < sizeof(fat_header))
+        return;
+
+    fat_header fat;
+    memcpy(&fat, header, sizeof(fat));
+    uint32_t count = OSSwapBigToHostInt32(fat.nfat_arch);
+    info.is_native = true;
+    info.arch = "Mach-O universal";
+    info.arch_matches = false;
+    for (uint32_t i = 0; i < count && i < 16; ++i) {
+        fat_arch slice;
+        if (!read_at(fd, &slice, sizeof(slice), (off_t)(sizeof(fat) + i * sizeof(slice))))
+            break;
+        if ((cpu_type_t)OSSwapBigToHostInt32((uint32_t)slice.cputype) == host_cpu_type())
+            info.arch_matches = true;
+    }
+}
+
+#endif
+
+void inspect_binary(int fd, const std::string &path, BinaryInfo &info)
+{
+    char header[256];
+    ssize_t length = pread(fd, header, sizeof(header), 0);
+    if (length < 4)
+        return;
+
+    if (header[0] == '#' && header[1] == '!') {
+        parse_shebang(header, (size_t)length, info);
+        return;
+    }
+
+#if defined(__linux__)
+    if (memcmp(header, ELFMAG, SELFMAG) != 0 || length < (ssize_t)sizeof(Elf64_Ehdr))
+        return;
+    if (header[EI_DATA] != ELFDATA2LSB) {
+        info.is_native = true;
+        info.arch = "ELF big-endian";
+        info.arch_matches = false;
+        return;
+    }
+
+    if (header[EI_CLASS] == ELFCLASS64)
+        parse_elf<Elf64_Ehdr, Elf64_Phdr, Elf64_Dyn>(fd, path, info);
+    else if (header[EI_CLASS] == ELFCLASS32)
+        parse_elf<Elf32_Ehdr, Elf32_Phdr, Elf32_Dyn>(fd, path, info);
+#elif defined(__APPLE__)
+    (void)path;
+    parse_mach_o(fd, (const unsigned char *)header, (size_t)length, info);
+#else
+    (void)path;
+#endif
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+OBS Starter Plugin - Executable Inspection
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// What exec of a file needs besides the file itself
+struct BinaryInfo {
+    bool is_script = false;
+    bool is_native = false;
+    // False when the binary was built for another architecture than OBS
+    bool arch_matches = true;
+    std::string arch;
+    // Shebang interpreter or ELF program interpreter (ld.so)
+    std::string interpreter;
+    // Program named after "#!/usr/bin/env", program_path is empty when not in $PATH
+    std::string program;
+    std::string program_path;
+    std::vector<std::string> libraries;
+    std::vector<std::string> missing_libraries;
+};
+
+#ifndef _WIN32
+// Parses the shebang or ELF headers of the opened file at path
+void inspect_binary(int fd, const std::string &path, BinaryInfo &info);
+#endif
@@ -18,11 +18,13 @@ the Free Software Foundation; either version 2 of the License, or
 #include <QApplication>
 #include <QStyle>
 #include <QTimer>
+#include <QThreadPool>
+#include <QCoreApplication>
 
 ExecutableSection::ExecutableSection(const ExecutableConfig &config, QWidget *parent)
     : QGroupBox("Executable Configuration", parent)
 {
-    setFixedHeight(160); // Increased height for additional checkbox
+    setFixedHeight(320); // Increased height for the run mode, launch, replica, in-process options and preflight status
     
     // Create layout
     QGridLayout *layout = new QGridLayout(this);
@@ -62,12 +64,68 @@ ExecutableSection::ExecutableSection(const ExecutableConfig &config, QWidget *pa
     minimizeCheckBox = new QCheckBox("Start minimized", this);
     minimizeCheckBox->setChecked(false); // Default disabled
     
+    // In-process: load a helper library on a worker thread instead of starting a process
+    inProcessCheckBox = new QCheckBox("Load in-process (helper library)", this);
+    inProcessCheckBox->setChecked(false);
+    inProcessCheckBox->setToolTip("For small helpers built against obs-starter-helper.h; always stopped with OBS");
+    connect(inProcessCheckBox, &QCheckBox::toggled, this, &ExecutableSection::onInProcessToggled);
+    
+    // Run mode: long-running helper or one-shot job queued on a frontend event
+    QLabel *triggerLabel = new QLabel("Run:", this);
+    triggerComboBox = new QComboBox(this);
+    triggerComboBox->addItem("With OBS (long-running)", (int)JobTrigger::None);
+    triggerComboBox->addItem("As job after recording stops", (int)JobTrigger::RecordingStopped);
+    triggerComboBox->addItem("As job after replay is saved", (int)JobTrigger::ReplaySaved);
+    triggerComboBox->addItem("As job after streaming stops", (int)JobTrigger::StreamingStopped);
+    triggerComboBox->setToolTip("Jobs get the output file as argument and wait while streaming or recording");
+    connect(triggerComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &ExecutableSection::onTriggerChanged);
+    
+    // Launch phase: how early a helper starts relative to OBS's own startup
+    QLabel *launchLabel = new QLabel("Launch:", this);
+    launchPhaseComboBox = new QComboBox(this);
+    launchPhaseComboBox->addItem("Early (while OBS loads)", (int)LaunchPhase::Early);
+    launchPhaseComboBox->addItem("After OBS has loaded", (int)LaunchPhase::AfterLoad);
+    launchPhaseComboBox->addItem("When idle after load", (int)LaunchPhase::Idle);
+    launchPhaseComboBox->setCurrentIndex(1); // Default after load
+    launchPhaseComboBox->setToolTip("Start helpers that do not need OBS early to shorten startup");
+    connect(launchPhaseComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &ExecutableSection::onLaunchPhaseChanged);
+    
+    launchDelaySpinBox = new QSpinBox(this);
+    launchDelaySpinBox->setRange(0, 3600);
+    launchDelaySpinBox->setSuffix(" s");
+    launchDelaySpinBox->setToolTip("Seconds OBS must have been idle (low CPU use) after loading");
+    launchDelaySpinBox->setEnabled(false);
+    
+    // Replicas: identical worker processes, each told its shard through the environment
+    QLabel *replicasLabel = new QLabel("Replicas:", this);
+    replicasSpinBox = new QSpinBox(this);
+    replicasSpinBox->setRange(0, 64);
+    replicasSpinBox->setSpecialValueText("Auto");
+    replicasSpinBox->setValue(1);
+    replicasSpinBox->setToolTip("Worker processes to run; Auto starts one per physical CPU core not reserved for OBS");
+    
+    // Preflight status, filled in asynchronously
+    preflightLabel = new QLabel(this);
+    preflightLabel->setWordWrap(true);
+    connect(pathLineEdit, &QLineEdit::textChanged, this, &ExecutableSection::clearPreflight);
+    
     // Layout setup with better spacing and alignment
     layout->addWidget(pathLabel, 0, 0, 1, 1);
     layout->addWidget(pathLineEdit, 0, 1, 1, 2);
     layout->addWidget(browseButton, 0, 3, 1, 1);
-    layout->addWidget(shutdownCheckBox, 1, 1, 1, 3);
-    layout->addWidget(minimizeCheckBox, 2, 1, 1, 3);
+    layout->addWidget(triggerLabel, 1, 0, 1, 1);
+    layout->addWidget(triggerComboBox, 1, 1, 1, 3);
+    layout->addWidget(launchLabel, 2, 0, 1, 1);
+    layout->addWidget(launchPhaseComboBox, 2, 1, 1, 2);
+    layout->addWidget(launchDelaySpinBox, 2, 3, 1, 1);
+    layout->addWidget(replicasLabel, 3, 0, 1, 1);
+    layout->addWidget(replicasSpinBox, 3, 1, 1, 1);
+    layout->addWidget(shutdownCheckBox, 4, 1, 1, 3);
+    layout->addWidget(minimizeCheckBox, 5, 1, 1, 3);
+    layout->addWidget(inProcessCheckBox, 6, 1, 1, 3);
+    layout->addWidget(preflightLabel, 7, 1, 1, 3);
     
     // Adjust row height and alignment to position browse button lower
     layout->setRowMinimumHeight(0, 35);  // Increased from 32 to give more space
@@ -102,6 +160,11 @@ ExecutableConfig ExecutableSection::getConfig() const
     config.path = pathLineEdit->text().toStdString();
     config.shutdown_enabled = shutdownCheckBox->isChecked();
     config.start_minimized = minimizeCheckBox->isChecked();
+    config.trigger = (JobTrigger)triggerComboBox->currentData().toInt();
+    config.launch_phase = (LaunchPhase)launchPhaseComboBox->currentData().toInt();
+    config.launch_delay = launchDelaySpinBox->value();
+    config.replicas = replicasSpinBox->value();
+    config.in_process = inProcessCheckBox->isChecked() && config.trigger == JobTrigger::None;
     return config;
 }
 
@@ -110,6 +173,14 @@ void ExecutableSection::setConfig(const ExecutableConfig &config)
     pathLineEdit->setText(QString::fromStdString(config.path));
     shutdownCheckBox->setChecked(config.shutdown_enabled);
     minimizeCheckBox->setChecked(config.start_minimized);
+    launchDelaySpinBox->setValue(config.launch_delay);
+    replicasSpinBox->setValue(config.replicas);
+    inProcessCheckBox->setChecked(config.in_process);
+    int phaseIndex = launchPhaseComboBox->findData((int)config.launch_phase);
+    launchPhaseComboBox->setCurrentIndex(phaseIndex >= 0 ? phaseIndex : 1);
+    int triggerIndex = triggerComboBox->findData((int)config.trigger);
+    triggerComboBox->setCurrentIndex(triggerIndex >= 0 ? triggerIndex : 0);
+    onTriggerChanged(triggerComboBox->currentIndex());
 }
 
 void ExecutableSection::browseForExecutable()
@@ -118,7 +189,7 @@ void ExecutableSection::browseForExecutable()
         this,
         "Select Executable",
         "",
-        "Executable Files (*.exe);;All Files (*.*)"
+        "Executable Files (*.exe);;Helper Libraries (*.dll *.so *.dylib);;All Files (*.*)"
     );
     
     if (!fileName.isEmpty()) {
@@ -131,6 +202,49 @@ void ExecutableSection::onRemoveClicked()
     emit removeRequested();
 }
 
+void ExecutableSection::setPreflightPending()
+{
+    preflightLabel->setStyleSheet("QLabel { color: gray; }");
+    preflightLabel->setText("Checking...");
+}
+
+void ExecutableSection::setPreflightResult(const PreflightResult &result)
+{
+    preflightLabel->setStyleSheet(result.ok ? "QLabel { color: #3c9a3c; }" : "QLabel { color: #d04040; }");
+    preflightLabel->setText(QString::fromStdString(result.message));
+}
+
+void ExecutableSection::clearPreflight()
+{
+    preflightLabel->clear();
+}
+
+void ExecutableSection::onTriggerChanged(int index)
+{
+    // Jobs exit on their own, auto-shutdown and the launch options only apply to helpers
+    bool isHelper = triggerComboBox->itemData(index).toInt() == (int)JobTrigger::None;
+    launchPhaseComboBox->setEnabled(isHelper);
+    inProcessCheckBox->setEnabled(isHelper);
+    onLaunchPhaseChanged(launchPhaseComboBox->currentIndex());
+    onInProcessToggled();
+}
+
+void ExecutableSection::onInProcessToggled()
+{
+    // A helper library runs inside OBS: one instance, no window, stopped with OBS
+    bool isHelper = triggerComboBox->currentData().toInt() == (int)JobTrigger::None;
+    bool inProcess = isHelper && inProcessCheckBox->isChecked();
+    shutdownCheckBox->setEnabled(isHelper && !inProcess);
+    minimizeCheckBox->setEnabled(!inProcess);
+    replicasSpinBox->setEnabled(isHelper && !inProcess);
+}
+
+void ExecutableSection::onLaunchPhaseChanged(int index)
+{
+    bool isIdle = launchPhaseComboBox->itemData(index).toInt() == (int)LaunchPhase::Idle;
+    launchDelaySpinBox->setEnabled(isIdle && launchPhaseComboBox->isEnabled());
+}
+
 ConfigDialog::ConfigDialog(QWidget *parent)
     : QDialog(parent)
 {
@@ -163,6 +277,27 @@ void ConfigDialog::closeEvent(QCloseEvent *event)
     event->accept();
 }
 
+void ConfigDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+
+    // The dialog is only hidden on close, so files may have changed since the last check
+    if (!event->spontaneous())
+        runPreflight(false);
+}
+
+void ConfigDialog::hideEvent(QHideEvent *event)
+{
+    QDialog::hideEvent(event);
+
+    // Cancel, closing the window and accept all hide the dialog; a save still
+    // waiting for its preflight must not go through afterwards
+    if (!event->spontaneous()) {
+        ++preflightGeneration;
+        saveButton->setEnabled(true);
+    }
+}
+
 void ConfigDialog::setupUI()
 {
     mainLayout = new QVBoxLayout(this);
@@ -228,17 +363,93 @@ void ConfigDialog::removeSection()
 }
 
 void ConfigDialog::saveSettings()
+{
+    runPreflight(true);
+}
+
+// Checks all entries on a pool thread so the dialog stays responsive
+void ConfigDialog::runPreflight(bool saveWhenDone)
+{
+    std::vector<ExecutableConfig> configs;
+    std::vector<QPointer<ExecutableSection>> checked;
+    
+    for (ExecutableSection *section : sections) {
+        ExecutableConfig config = section->getConfig();
+        if (!config.path.empty()) {
+            configs.push_back(config);
+            checked.push_back(section);
+            section->setPreflightPending();
+        }
+    }
+    
+    if (saveWhenDone)
+        saveButton->setEnabled(false);
+    
+    unsigned long long generation = ++preflightGeneration;
+    QPointer<ConfigDialog> dialog(this);
+    QThreadPool::globalInstance()->start([dialog, generation, checked, configs, saveWhenDone]() {
+        std::vector<PreflightResult> results = preflight_check_all(configs);
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [dialog, generation, checked, results, saveWhenDone]() {
+                if (dialog)
+                    dialog->onPreflightFinished(generation, checked, results, saveWhenDone);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void ConfigDialog::onPreflightFinished(unsigned long long generation,
+                                       const std::vector<QPointer<ExecutableSection>> &checked,
+                                       const std::vector<PreflightResult> &results, bool saveWhenDone)
+{
+    if (generation != preflightGeneration)
+        return;
+    
+    saveButton->setEnabled(true);
+    
+    int failures = 0;
+    for (size_t i = 0; i < checked.size() && i < results.size(); ++i) {
+        if (checked[i])
+            checked[i]->setPreflightResult(results[i]);
+        if (!results[i].ok)
+            failures++;
+    }
+    
+    if (!saveWhenDone)
+        return;
+    
+    if (failures > 0) {
+        QMessageBox::StandardButton answer = QMessageBox::warning(
+            this, "Preflight Check Failed",
+            QString("%1 executable(s) cannot be started, see the details in their sections.\n\nSave anyway?")
+                .arg(failures),
+            QMessageBox::Save | QMessageBox::Cancel, QMessageBox::Cancel);
+        if (answer != QMessageBox::Save)
+            return;
+    }
+    
+    commitSettings();
+}
+
+void ConfigDialog::commitSettings()
 {
     std::vector<ExecutableConfig> configs;
+    std::vector<int> origins;
     
     for (ExecutableSection *section : sections) {
         ExecutableConfig config = section->getConfig();
         if (!config.path.empty()) {
+            origins.push_back(section->originIndex());
+            // The saved list becomes the origin of the next save
+            section->setOriginIndex((int)configs.size());
             configs.push_back(config);
+        } else {
+            section->setOriginIndex(-1);
         }
     }
     
-    update_executable_configs(configs);
+    update_executable_configs(configs, origins);
     
     QMessageBox::information(this, "Settings Saved", 
                            "Configuration has been saved successfully.");
@@ -257,8 +468,9 @@ void ConfigDialog::loadSettings()
     // Load configurations
     std::vector<ExecutableConfig> configs = get_executable_configs();
     
-    for (const ExecutableConfig &config : configs) {
-        ExecutableSection *section = new ExecutableSection(config, scrollWidget);
+    for (size_t i = 0; i < configs.size(); ++i) {
+        ExecutableSection *section = new ExecutableSection(configs[i], scrollWidget);
+        section->setOriginIndex((int)i);
         connect(section, &ExecutableSection::removeRequested, [this, section]() {
             scrollLayout->removeWidget(section);
             auto it = std::find(sections.begin(), sections.end(), section);
@@ -18,16 +18,22 @@ the Free Software Foundation; either version 2 of the License, or
 #include <QPushButton>
 #include <QLineEdit>
 #include <QCheckBox>
+#include <QComboBox>
+#include <QSpinBox>
 #include <QLabel>
 #include <QFileDialog>
 #include <QGroupBox>
 #include <QResizeEvent>
 #include <QCloseEvent>
+#include <QShowEvent>
+#include <QHideEvent>
 #include <QPainter>
 #include <QPaintEvent>
+#include <QPointer>
 #include <vector>
 #include <string>
 #include <plugin-support.h>
+#include "preflight.h"
 
 // Custom button that draws a cross
 class CrossButton : public QPushButton
@@ -65,6 +71,12 @@ public:
     ExecutableSection(const ExecutableConfig &config = {}, QWidget *parent = nullptr);
     ExecutableConfig getConfig() const;
     void setConfig(const ExecutableConfig &config);
+    void setPreflightPending();
+    void setPreflightResult(const PreflightResult &result);
+
+    // Index of the saved entry this section was loaded from, -1 for a new one
+    int originIndex() const { return origin; }
+    void setOriginIndex(int index) { origin = index; }
 
 signals:
     void removeRequested();
@@ -75,13 +87,24 @@ protected:
 private slots:
     void browseForExecutable();
     void onRemoveClicked();
+    void onTriggerChanged(int index);
+    void onLaunchPhaseChanged(int index);
+    void onInProcessToggled();
+    void clearPreflight();
 
 private:
     QLineEdit *pathLineEdit;
     QCheckBox *shutdownCheckBox;
     QCheckBox *minimizeCheckBox;
+    QCheckBox *inProcessCheckBox;
+    QComboBox *triggerComboBox;
+    QComboBox *launchPhaseComboBox;
+    QSpinBox *launchDelaySpinBox;
+    QSpinBox *replicasSpinBox;
+    QLabel *preflightLabel;
     QPushButton *browseButton;
     CrossButton *removeButton;
+    int origin = -1;
 };
 
 class ConfigDialog : public QDialog
@@ -94,6 +117,8 @@ public:
 
 protected:
     void closeEvent(QCloseEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private slots:
     void addSection();
@@ -103,7 +128,14 @@ private slots:
 
 private:
     void setupUI();
+    void runPreflight(bool saveWhenDone);
+    void onPreflightFinished(unsigned long long generation, const std::vector<QPointer<ExecutableSection>> &checked,
+                             const std::vector<PreflightResult> &results, bool saveWhenDone);
+    void commitSettings();
     
+    // Bumped per preflight run so results of an outdated run are dropped
+    unsigned long long preflightGeneration = 0;
+
     QVBoxLayout *mainLayout;
     QScrollArea *scrollArea;
     QWidget *scrollWidget;
@@ -0,0 +1,534 @@
+/*
+OBS Starter Plugin - Local Control API Implementation
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#include "control-server.h"
+
+#include <obs-module.h>
+#include <plugin-support.h>
+
+#ifdef _WIN32
+
+void control_server_start()
+{
+    obs_log(LOG_INFO, "Control API is not available on this platform");
+}
+
+void control_server_stop() {}
+
+#else
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifdef MSG_NOSIGNAL
+#define MSG_NOSIGNAL_FLAG MSG_NOSIGNAL
+#else
+#define MSG_NOSIGNAL_FLAG 0
+#endif
+
+// Requests are single lines, anything longer is a misbehaving client
+static const size_t MAX_REQUEST_LINE = 4096;
+static const size_t MAX_PENDING_OUTPUT = 1 << 20;
+static const size_t MAX_CLIENTS = 128;
+
+struct ControlClient {
+    int fd;
+    std::string input;
+    std::string output;
+    bool http;
+    bool close_after_write;
+};
+
+static std::thread server_thread;
+static std::atomic<bool> server_running{false};
+static int listen_fd = -1;
+static int wake_pipe[2] = {-1, -1};
+static std::string socket_path;
+static unsigned long long requests_total = 0;
+static unsigned long long request_errors_total = 0;
+
+static bool set_nonblocking_cloexec(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        return false;
+    return fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+static std::string resolve_socket_path()
+{
+    const char *override_path = getenv("OBS_STARTER_SOCKET");
+    if (override_path && *override_path)
+        return override_path;
+
+    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir)
+        return std::string(runtime_dir) + "/obs-starter.sock";
+
+    std::string path;
+    char *config_path = obs_module_get_config_path(obs_current_module(), "control.sock");
+    if (config_path) {
+        path = config_path;
+        bfree(config_path);
+    }
+    return path;
+}
+
+static const char *result_error(HelperControlResult result)
+{
+    switch (result) {
+    case HelperControlResult::NoSuchHelper:
+        return "no-such-helper";
+    case HelperControlResult::AlreadyRunning:
+        return "already-running";
+    case HelperControlResult::NotRunning:
+        return "not-running";
+    case HelperControlResult::SpawnFailed:
+        return "spawn-failed";
+    default:
+        return nullptr;
+    }
+}
+
+static void append_format(std::string &out, const char *format, ...)
+{
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0)
+        out.append(buffer, (size_t)length < sizeof(buffer) ? (size_t)length : sizeof(buffer) - 1);
+}
+
+static std::string escape_label(const std::string &value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+static std::string render_metrics()
+{
+    std::vector<HelperStatus> statuses = get_helper_statuses();
+    std::string out;
+    out.reserve(1024 + statuses.size() * 1024);
+
+    std::vector<std::string> labels;
+    labels.reserve(statuses.size());
+    for (const HelperStatus &status : statuses)
+        labels.push_back("index=\"" + std::to_string(status.index) + "\",path=\"" + escape_label(status.path) + "\"");
+
+    out += "# HELP obs_starter_helper_up Whether the helper process is running.\n";
+    out += "# TYPE obs_starter_helper_up gauge\n";
+    for (size_t i = 0; i < statuses.size(); ++i)
+        append_format(out, "obs_starter_helper_up{%s} %d\n", labels[i].c_str(), statuses[i].running ? 1 : 0);
+
+    out += "# HELP obs_starter_helper_replicas_running Running replicas of the helper.\n";
+    out += "# TYPE obs_starter_helper_replicas_running gauge\n";
+    for (size_t i = 0; i < statuses.size(); ++i)
+        append_format(out, "obs_starter_helper_replicas_running{%s} %zu\n", labels[i].c_str(),
+                      statuses[i].replica_pids.size());
+
+    out += "# HELP obs_starter_helper_restarts_total Restarts requested for the helper and replaced replicas.\n";
+    out += "# TYPE obs_starter_helper_restarts_total counter\n";
+    for (size_t i = 0; i < statuses.size(); ++i)
+        append_format(out, "obs_starter_helper_restarts_total{%s} %u\n", labels[i].c_str(), statuses[i].restarts);
+
+    out += "# HELP obs_starter_helper_uptime_seconds Time since the helper (its oldest replica) was started.\n";
+    out += "# TYPE obs_starter_helper_uptime_seconds gauge\n";
+    for (size_t i = 0; i < statuses.size(); ++i)
+        append_format(out, "obs_starter_helper_uptime_seconds{%s} %.3f\n", labels[i].c_str(),
+                      statuses[i].uptime_seconds);
+
+    out += "# HELP obs_starter_helper_cpu_seconds_total User and system CPU time of the helper processes.\n";
+    out += "# TYPE obs_starter_helper_cpu_seconds_total counter\n";
+    for (size_t i = 0; i < statuses.size(); ++i)
+        append_format(out, "obs_starter_helper_cpu_seconds_total{%s} %.3f\n", labels[i].c_str(),
+                      statuses[i].cpu_seconds);
+
+    out += "# HELP obs_starter_helper_resident_memory_bytes Resident set size of the helper processes.\n";
+    out += "# TYPE obs_starter_helper_resident_memory_bytes gauge\n";
+    for (size_t i = 0; i < statuses.size(); ++i)
+        append_format(out, "obs_starter_helper_resident_memory_bytes{%s} %llu\n", labels[i].c_str(),
+                      statuses[i].rss_bytes);
+
+    out += "# HELP obs_starter_helper_spawn_latency_seconds Time taken to spawn the helper process.\n";
+    out += "# TYPE obs_starter_helper_spawn_latency_seconds histogram\n";
+    for (size_t i = 0; i < statuses.size(); ++i) {
+        for (size_t b = 0; b < SPAWN_LATENCY_BUCKET_COUNT; ++b)
+            append_format(out, "obs_starter_helper_spawn_latency_seconds_bucket{%s,le=\"%g\"} %llu\n",
+                          labels[i].c_str(), spawn_latency_bucket_bounds[b], statuses[i].spawn_latency_buckets[b]);
+        append_format(out, "obs_starter_helper_spawn_latency_seconds_bucket{%s,le=\"+Inf\"} %llu\n",
+                      labels[i].c_str(), statuses[i].spawn_latency_count);
+        append_format(out, "obs_starter_helper_spawn_latency_seconds_sum{%s} %.6f\n", labels[i].c_str(),
+                      statuses[i].spawn_latency_sum);
+        append_format(out, "obs_starter_helper_spawn_latency_seconds_count{%s} %llu\n", labels[i].c_str(),
+                      statuses[i].spawn_latency_count);
+    }
+
+    out += "# HELP obs_starter_control_requests_total Requests handled by the control API.\n";
+    out += "# TYPE obs_starter_control_requests_total counter\n";
+    append_format(out, "obs_starter_control_requests_total %llu\n", requests_total);
+    out += "# HELP obs_starter_control_request_errors_total Control API requests answered with ERR.\n";
+    out += "# TYPE obs_starter_control_request_errors_total counter\n";
+    append_format(out, "obs_starter_control_request_errors_total %llu\n", request_errors_total);
+    return out;
+}
+
+static void append_status_line(std::string &out, const HelperStatus &status)
+{
+    append_format(out,
+                  "index=%zu state=%s pid=%lld replicas=%zu/%u restarts=%u exit=%d uptime=%.3f cpu=%.3f rss=%llu path=",
+                  status.index, status.running ? "running" : "stopped", status.pid, status.replica_pids.size(),
+                  status.replicas, status.restarts, status.last_exit_status, status.uptime_seconds, status.cpu_seconds, status.rss_bytes);
+    out += status.path;
+    out += '\n';
+}
+
+static bool parse_index(const std::string &argument, size_t &index)
+{
+    if (argument.empty() || argument.size() > 9)
+        return false;
+    for (char c : argument) {
+        if (c < '0' || c > '9')
+            return false;
+    }
+    index = (size_t)strtoul(argument.c_str(), nullptr, 10);
+    return true;
+}
+
+// Protocol: one request per line, "<COMMAND> [index]". Replies start with
+// "OK" or "ERR <reason>"; LIST and METRICS reply "OK <n>" followed by n lines.
+static void handle_request(const std::string &line, std::string &out)
+{
+    requests_total++;
+
+    size_t space = line.find(' ');
+    std::string command = line.substr(0, space);
+    std::string argument = space == std::string::npos ? std::string() : line.substr(space + 1);
+
+    if (command == "LIST") {
+        std::vector<HelperStatus> statuses = get_helper_statuses();
+        append_format(out, "OK %zu\n", statuses.size());
+        for (const HelperStatus &status : statuses)
+            append_status_line(out, status);
+        return;
+    }
+
+    if (command == "METRICS") {
+        std::string metrics = render_metrics();
+        size_t lines = 0;
+        for (char c : metrics)
+            lines += c == '\n';
+        append_format(out, "OK %zu\n", lines);
+        out += metrics;
+        return;
+    }
+
+    size_t index = 0;
+    bool has_index = parse_index(argument, index);
+
+    if (command == "STATUS" && has_index) {
+        std::vector<HelperStatus> statuses = get_helper_statuses();
+        if (index >= statuses.size()) {
+            request_errors_total++;
+            out += "ERR no-such-helper\n";
+            return;
+        }
+        out += "OK ";
+        append_status_line(out, statuses[index]);
+        return;
+    }
+
+    HelperControlResult result;
+    if (command == "START" && has_index) {
+        result = start_helper(index);
+    } else if (command == "STOP" && has_index) {
+        result = stop_helper(index);
+    } else if (command == "RESTART" && has_index) {
+        result = restart_helper(index);
+    } else {
+        request_errors_total++;
+        out += "ERR bad-request\n";
+        return;
+    }
+
+    const char *error = result_error(result);
+    if (error) {
+        request_errors_total++;
+        append_format(out, "ERR %s\n", error);
+    } else {
+        out += "OK\n";
+    }
+}
+
+// Minimal HTTP/1.0 responder so Prometheus can scrape through a socket proxy
+static void handle_http_request(const std::string &request_line, std::string &out)
+{
+    requests_total++;
+
+    std::string body;
+    const char *status = "200 OK";
+    if (request_line.compare(0, 13, "GET /metrics ") == 0 || request_line == "GET /metrics") {
+        body = render_metrics();
+    } else {
+        request_errors_total++;
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    append_format(out, "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n",
+                  status, body.size());
+    out += body;
+}
+
+static void process_input(ControlClient &client)
+{
+    size_t start = 0;
+    size_t newline;
+    while (!client.close_after_write && (newline = client.input.find('\n', start)) != std::string::npos) {
+        std::string line = client.input.substr(start, newline - start);
+        start = newline + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (client.http) {
+            // Headers are ignored, the blank line ends the request
+            if (line.empty())
+                client.close_after_write = true;
+            continue;
+        }
+
+        if (line.compare(0, 4, "GET ") == 0) {
+            client.http = true;
+            handle_http_request(line, client.output);
+            continue;
+        }
+
+        if (!line.empty())
+            handle_request(line, client.output);
+    }
+    client.input.erase(0, start);
+
+    if (client.input.size() > MAX_REQUEST_LINE) {
+        client.output += "ERR request-too-long\n";
+        client.close_after_write = true;
+    }
+}
+
+// Returns false once the client should be dropped
+static bool read_client(ControlClient &client)
+{
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = read(client.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            client.input.append(buffer, (size_t)n);
+            process_input(client);
+            if (client.close_after_write)
+                return true;
+            continue;
+        }
+        if (n == 0)
+            return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+}
+
+static bool write_client(ControlClient &client)
+{
+    while (!client.output.empty()) {
+        ssize_t n = send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL_FLAG);
+        if (n > 0) {
+            client.output.erase(0, (size_t)n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            return client.output.size() <= MAX_PENDING_OUTPUT;
+        return false;
+    }
+    return !client.close_after_write;
+}
+
+static void accept_clients(std::vector<ControlClient> &clients)
+{
+    for (;;) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0)
+            return;
+
+        if (clients.size() >= MAX_CLIENTS || !set_nonblocking_cloexec(fd)) {
+            close(fd);
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        clients.push_back({fd, std::string(), std::string(), false, false});
+    }
+}
+
+static void server_loop()
+{
+    std::vector<ControlClient> clients;
+    std::vector<struct pollfd> fds;
+
+    while (server_running) {
+        fds.clear();
+        fds.push_back({wake_pipe[0], POLLIN, 0});
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const ControlClient &client : clients) {
+            short events = client.close_after_write ? 0 : POLLIN;
+            if (!client.output.empty())
+                events |= POLLOUT;
+            fds.push_back({client.fd, events, 0});
+        }
+
+        int ready = poll(fds.data(), (nfds_t)fds.size(), -1);
+        if (ready < 0 && errno != EINTR) {
+            obs_log(LOG_ERROR, "Control API poll failed: %s", strerror(errno));
+            break;
+        }
+
+        if (ready <= 0)
+            continue;
+        if (fds[0].revents)
+            break;
+        if (fds[1].revents & POLLIN)
+            accept_clients(clients);
+
+        // Clients accepted above have no pollfd yet and are serviced next round
+        size_t polled = fds.size() - 2;
+        std::vector<ControlClient> kept;
+        kept.reserve(clients.size());
+        for (size_t i = 0; i < clients.size(); ++i) {
+            ControlClient &client = clients[i];
+            bool keep = true;
+            if (i < polled) {
+                short revents = fds[i + 2].revents;
+                if (revents & (POLLIN | POLLHUP | POLLERR))
+                    keep = read_client(client);
+                if (keep && !client.output.empty())
+                    keep = write_client(client);
+                else if (keep && client.close_after_write)
+                    keep = false;
+            }
+            if (keep)
+                kept.push_back(std::move(client));
+            else
+                close(client.fd);
+        }
+        clients.swap(kept);
+    }
+
+    for (const ControlClient &client : clients)
+        close(client.fd);
+}
+
+void control_server_start()
+{
+    if (server_running)
+        return;
+
+    socket_path = resolve_socket_path();
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        obs_log(LOG_WARNING, "Control API disabled, unusable socket path: %s", socket_path.c_str());
+        return;
+    }
+    memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || !set_nonblocking_cloexec(listen_fd)) {
+        obs_log(LOG_WARNING, "Control API disabled, cannot create socket: %s", strerror(errno));
+        if (listen_fd >= 0)
+            close(listen_fd);
+        listen_fd = -1;
+        return;
+    }
+
+    // A socket file nobody answers on is left over from a crash
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0) {
+        bool in_use = connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0;
+        close(probe);
+        if (in_use) {
+            obs_log(LOG_WARNING, "Control API disabled, %s is served by another instance", socket_path.c_str());
+            close(listen_fd);
+            listen_fd = -1;
+            return;
+        }
+    }
+    unlink(socket_path.c_str());
+
+    // The process umask is left alone since other OBS threads may be creating files;
+    // no client can connect before listen(), so tightening the mode afterwards is enough
+    int bound = bind(listen_fd, (struct sockaddr *)&address, sizeof(address));
+    if (bound == 0)
+        bound = chmod(socket_path.c_str(), 0600);
+
+    if (bound < 0 || listen(listen_fd, SOMAXCONN) < 0 || pipe(wake_pipe) < 0) {
+        obs_log(LOG_WARNING, "Control API disabled, cannot listen on %s: %s", socket_path.c_str(),
+                strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return;
+    }
+    set_nonblocking_cloexec(wake_pipe[0]);
+    set_nonblocking_cloexec(wake_pipe[1]);
+
+    server_running = true;
+    server_thread = std::thread(server_loop);
+    obs_log(LOG_INFO, "Control API listening on %s", socket_path.c_str());
+}
+
+void control_server_stop()
+{
+    if (!server_running)
+        return;
+
+    server_running = false;
+    char wake = 0;
+    if (write(wake_pipe[1], &wake, 1) < 0)
+        obs_log(LOG_WARNING, "Failed to wake control API thread");
+    if (server_thread.joinable())
+        server_thread.join();
+
+    close(listen_fd);
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+    listen_fd = -1;
+    wake_pipe[0] = wake_pipe[1] = -1;
+    unlink(socket_path.c_str());
+    obs_log(LOG_INFO, "Control API stopped");
+}
+
+#endif
@@ -0,0 +1,18 @@
+/*
+OBS Starter Plugin - Local Control API
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#pragma once
+
+// Starts serving the control and metrics API on a unix-domain socket.
+// All requests are handled by a single event loop thread, never the UI thread.
+void control_server_start();
+
+// Stops the event loop and removes the socket
+void control_server_stop();
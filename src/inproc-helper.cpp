@@ -0,0 +1,298 @@
+/*
+OBS Starter Plugin - In-process Helpers Implementation
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#include "inproc-helper.h"
+#include "obs-starter-helper.h"
+
+#include <obs-module.h>
+#include <plugin-support.h>
+#include <util/platform.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Events are small notifications, a helper that falls this far behind only needs the latest ones
+static const size_t EVENT_QUEUE_SIZE = 64;
+static const uint32_t TICK_BUDGET_MS = 20;
+// A call still running after this long is considered hung, its thread is abandoned
+static const uint64_t HANG_TIMEOUT_NS = 2000000000ULL;
+static const auto STOP_TIMEOUT = std::chrono::seconds(2);
+static const auto WATCHDOG_INTERVAL = std::chrono::milliseconds(50);
+
+struct QueuedEvent {
+    uint32_t type;
+    std::string path;
+};
+
+struct InProcessHelper {
+    std::string path;
+    void *module = nullptr;
+    const obs_starter_helper_api *api = nullptr;
+    obs_starter_helper_host host = {};
+    std::thread thread;
+
+    // Guards the fields below
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<QueuedEvent> events;
+    unsigned long long dropped_events = 0;
+    bool stopping = false;
+    bool exited = false;
+    int exit_status = 0;
+
+    // Call in progress as seen by the watchdog, started_ns is 0 while idle
+    std::atomic<uint64_t> call_started_ns{0};
+    std::atomic<uint64_t> call_budget_ns{0};
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> hung{false};
+};
+
+// One watchdog thread serves all loaded helpers
+static std::mutex watchdog_mutex;
+static std::condition_variable watchdog_cv;
+static std::vector<InProcessHelper *> watched_helpers;
+static std::thread watchdog_thread;
+
+static void host_log(void *host_data, int level, const char *message)
+{
+    InProcessHelper *helper = (InProcessHelper *)host_data;
+    obs_log(level, "[%s] %s", helper->path.c_str(), message ? message : "");
+}
+
+static int host_should_stop(void *host_data)
+{
+    return ((InProcessHelper *)host_data)->cancel ? 1 : 0;
+}
+
+static void watchdog_loop()
+{
+    std::unique_lock<std::mutex> lock(watchdog_mutex);
+    while (!watched_helpers.empty()) {
+        watchdog_cv.wait_for(lock, WATCHDOG_INTERVAL);
+
+        uint64_t now = os_gettime_ns();
+        for (InProcessHelper *helper : watched_helpers) {
+            uint64_t started = helper->call_started_ns;
+            if (!started || helper->hung || now < started)
+                continue;
+
+            uint64_t elapsed = now - started;
+            if (elapsed > helper->call_budget_ns && !helper->cancel) {
+                helper->cancel = true;
+                obs_log(LOG_WARNING, "In-process helper %s exceeded its %.0f ms budget, asking it to stop",
+                        helper->path.c_str(), (double)helper->call_budget_ns / 1e6);
+            }
+            if (elapsed > HANG_TIMEOUT_NS) {
+                // A thread cannot be killed safely; leave it and its library behind
+                helper->hung = true;
+                obs_log(LOG_ERROR, "In-process helper %s did not return for %.1f s, abandoning it",
+                        helper->path.c_str(), (double)elapsed / 1e9);
+            }
+        }
+    }
+}
+
+static void watch_helper(InProcessHelper *helper)
+{
+    std::lock_guard<std::mutex> lock(watchdog_mutex);
+    watched_helpers.push_back(helper);
+    if (watched_helpers.size() == 1)
+        watchdog_thread = std::thread(watchdog_loop);
+}
+
+static void unwatch_helper(InProcessHelper *helper)
+{
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(watchdog_mutex);
+        watched_helpers.erase(std::remove(watched_helpers.begin(), watched_helpers.end(), helper),
+                              watched_helpers.end());
+        if (watched_helpers.empty())
+            finished = std::move(watchdog_thread);
+    }
+    watchdog_cv.notify_all();
+    if (finished.joinable())
+        finished.join();
+}
+
+// Runs one helper callback under the watchdog
+template<typename Call> static auto watched_call(InProcessHelper *helper, uint64_t budget_ns, Call call)
+{
+    helper->call_budget_ns = budget_ns;
+    helper->call_started_ns = os_gettime_ns();
+    auto result = call();
+    helper->call_started_ns = 0;
+    return result;
+}
+
+static void worker_main(InProcessHelper *helper)
+{
+    const obs_starter_helper_api *api = helper->api;
+    uint64_t budget_ns = (uint64_t)TICK_BUDGET_MS * 1000000ULL;
+
+    void *state = watched_call(helper, HANG_TIMEOUT_NS, [&] { return api->init(&helper->host); });
+
+    std::unique_lock<std::mutex> lock(helper->mutex);
+    if (!state) {
+        obs_log(LOG_WARNING, "In-process helper %s failed to initialize", helper->path.c_str());
+        helper->exit_status = -1;
+        helper->exited = true;
+        helper->cv.notify_all();
+        return;
+    }
+
+    uint64_t interval_ns = api->tick ? (uint64_t)api->tick_interval_ms * 1000000ULL : 0;
+    uint64_t next_tick = os_gettime_ns() + interval_ns;
+    int result = 0;
+
+    while (!helper->stopping && !helper->hung && result == 0) {
+        if (helper->events.empty()) {
+            if (!interval_ns) {
+                helper->cv.wait(lock);
+                continue;
+            }
+            uint64_t now = os_gettime_ns();
+            if (now < next_tick) {
+                helper->cv.wait_for(lock, std::chrono::nanoseconds(next_tick - now));
+                continue;
+            }
+        }
+
+        if (!helper->events.empty()) {
+            QueuedEvent queued = std::move(helper->events.front());
+            helper->events.pop_front();
+            lock.unlock();
+            if (api->event) {
+                obs_starter_helper_event event = {queued.type, queued.path.empty() ? nullptr : queued.path.c_str()};
+                result = watched_call(helper, budget_ns, [&] { return api->event(state, &event); });
+            }
+            lock.lock();
+        } else {
+            lock.unlock();
+            result = watched_call(helper, budget_ns, [&] { return api->tick(state); });
+            lock.lock();
+            // Missed ticks are skipped, not made up in a burst
+            next_tick = std::max(next_tick + interval_ns, os_gettime_ns());
+        }
+        if (!helper->stopping)
+            helper->cancel = false;
+    }
+
+    if (result != 0)
+        obs_log(LOG_WARNING, "In-process helper %s stopped with status %d", helper->path.c_str(), result);
+    helper->exit_status = result;
+    lock.unlock();
+
+    if (!helper->hung && api->shutdown)
+        watched_call(helper, HANG_TIMEOUT_NS, [&] {
+            api->shutdown(state);
+            return 0;
+        });
+
+    lock.lock();
+    helper->exited = true;
+    helper->cv.notify_all();
+}
+
+InProcessHelper *inproc_helper_load(const std::string &path)
+{
+    void *module = os_dlopen(path.c_str());
+    if (!module) {
+        obs_log(LOG_WARNING, "Failed to load in-process helper: %s", path.c_str());
+        return nullptr;
+    }
+
+    obs_starter_helper_get_api_t get_api = (obs_starter_helper_get_api_t)os_dlsym(module, OBS_STARTER_HELPER_ENTRY);
+    const obs_starter_helper_api *api = get_api ? get_api(OBS_STARTER_HELPER_ABI_VERSION) : nullptr;
+    if (!api || api->abi_version != OBS_STARTER_HELPER_ABI_VERSION || !api->init) {
+        obs_log(LOG_WARNING, "In-process helper %s does not export a compatible %s (ABI version %d)", path.c_str(),
+                OBS_STARTER_HELPER_ENTRY, OBS_STARTER_HELPER_ABI_VERSION);
+        os_dlclose(module);
+        return nullptr;
+    }
+
+    InProcessHelper *helper = new InProcessHelper();
+    helper->path = path;
+    helper->module = module;
+    helper->api = api;
+    helper->host.abi_version = OBS_STARTER_HELPER_ABI_VERSION;
+    helper->host.tick_budget_ms = TICK_BUDGET_MS;
+    helper->host.host_data = helper;
+    helper->host.log = host_log;
+    helper->host.should_stop = host_should_stop;
+
+    watch_helper(helper);
+    helper->thread = std::thread(worker_main, helper);
+    obs_log(LOG_INFO, "Loaded in-process helper: %s", path.c_str());
+    return helper;
+}
+
+bool inproc_helper_finished(InProcessHelper *helper)
+{
+    std::lock_guard<std::mutex> lock(helper->mutex);
+    return helper->exited || helper->hung;
+}
+
+int inproc_helper_exit_status(InProcessHelper *helper)
+{
+    std::lock_guard<std::mutex> lock(helper->mutex);
+    return helper->exited ? helper->exit_status : -1;
+}
+
+void inproc_helper_post_event(InProcessHelper *helper, uint32_t type, const char *path)
+{
+    {
+        std::lock_guard<std::mutex> lock(helper->mutex);
+        if (helper->stopping || helper->exited)
+            return;
+
+        if (helper->events.size() >= EVENT_QUEUE_SIZE) {
+            helper->events.pop_front();
+            if (helper->dropped_events++ == 0)
+                obs_log(LOG_WARNING, "In-process helper %s is not keeping up, dropping events",
+                        helper->path.c_str());
+        }
+        helper->events.push_back({type, path ? path : ""});
+    }
+    helper->cv.notify_one();
+}
+
+int inproc_helper_unload(InProcessHelper *helper)
+{
+    bool exited;
+    {
+        std::unique_lock<std::mutex> lock(helper->mutex);
+        helper->stopping = true;
+        helper->cancel = true;
+        helper->cv.notify_all();
+        exited = helper->cv.wait_for(lock, STOP_TIMEOUT, [helper] { return helper->exited || helper->hung; }) &&
+                 helper->exited;
+    }
+    unwatch_helper(helper);
+
+    if (!exited) {
+        // Its code may still be running, so the library must stay mapped
+        obs_log(LOG_ERROR, "In-process helper %s did not stop, leaving it loaded", helper->path.c_str());
+        helper->thread.detach();
+        return -1;
+    }
+
+    helper->thread.join();
+    os_dlclose(helper->module);
+    int exit_status = helper->exit_status;
+    obs_log(LOG_INFO, "Unloaded in-process helper: %s", helper->path.c_str());
+    delete helper;
+    return exit_status;
+}
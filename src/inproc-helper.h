@@ -0,0 +1,35 @@
+/*
+OBS Starter Plugin - In-process Helpers
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+struct InProcessHelper;
+
+// Loads the helper library at path and starts its worker thread, which
+// calls init and then delivers ticks and events. Returns nullptr if the
+// library cannot be loaded or does not export a compatible ABI.
+InProcessHelper *inproc_helper_load(const std::string &path);
+
+// True once the worker has returned, because the helper stopped itself,
+// failed to initialize, or was abandoned by the watchdog
+bool inproc_helper_finished(InProcessHelper *helper);
+
+// Value that stopped a finished helper, -1 for one that was abandoned
+int inproc_helper_exit_status(InProcessHelper *helper);
+
+// Queues an obs_starter_helper_event_type; the oldest event is dropped when the queue is full
+void inproc_helper_post_event(InProcessHelper *helper, uint32_t type, const char *path);
+
+// Stops the helper (calling its shutdown), unloads the library and frees
+// helper. Returns the value that stopped the helper, 0 for a requested stop.
+int inproc_helper_unload(InProcessHelper *helper);
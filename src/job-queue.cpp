@@ -0,0 +1,391 @@
+/*
+OBS Starter Plugin - Deferred Job Queue Implementation
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#include "job-queue.h"
+
+#include <obs-module.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+// Heavy jobs (remux, upload, thumbnails) compete for disk and CPU, keep the pool small
+static const size_t JOB_WORKER_COUNT = 2;
+// Time running jobs get to exit after SIGTERM before they are killed at shutdown
+static const auto JOB_STOP_GRACE = std::chrono::seconds(2);
+
+struct QueuedJob {
+    std::string command;
+    std::string argument;
+};
+
+struct ActiveJob {
+    QueuedJob job;
+#ifdef _WIN32
+    HANDLE process;
+    // Holds the job's whole process tree, so stopping reaches its children too
+    HANDLE job_object;
+#else
+    pid_t pid;
+#endif
+    // Set once shutdown has asked the job to stop
+    bool stop_requested;
+};
+
+// Guards everything below; active_jobs holds jobs whose process is running
+static std::mutex queue_mutex;
+static std::condition_variable queue_cv;
+static std::deque<QueuedJob> pending_jobs;
+static std::vector<ActiveJob *> active_jobs;
+static std::vector<std::thread> workers;
+static bool queue_running = false;
+static bool queue_stopping = false;
+// Nothing runs until OBS has finished loading and reports its real live state
+static bool live = true;
+
+const char *job_trigger_to_string(JobTrigger trigger)
+{
+    switch (trigger) {
+    case JobTrigger::RecordingStopped:
+        return "recording_stopped";
+    case JobTrigger::ReplaySaved:
+        return "replay_saved";
+    case JobTrigger::StreamingStopped:
+        return "streaming_stopped";
+    default:
+        return "none";
+    }
+}
+
+JobTrigger job_trigger_from_string(const char *value)
+{
+    if (!value)
+        return JobTrigger::None;
+    if (strcmp(value, "recording_stopped") == 0)
+        return JobTrigger::RecordingStopped;
+    if (strcmp(value, "replay_saved") == 0)
+        return JobTrigger::ReplaySaved;
+    if (strcmp(value, "streaming_stopped") == 0)
+        return JobTrigger::StreamingStopped;
+    return JobTrigger::None;
+}
+
+// Writes pending and active jobs to job-queue.json; queue_mutex must be held
+static void save_queue()
+{
+    char *queue_path = obs_module_get_config_path(obs_current_module(), "job-queue.json");
+    if (!queue_path)
+        return;
+
+    obs_data_t *data = obs_data_create();
+    obs_data_array_t *array = obs_data_array_create();
+
+    auto push_job = [array](const QueuedJob &job) {
+        obs_data_t *item = obs_data_create();
+        obs_data_set_string(item, "command", job.command.c_str());
+        obs_data_set_string(item, "argument", job.argument.c_str());
+        obs_data_array_push_back(array, item);
+        obs_data_release(item);
+    };
+    // Interrupted jobs go first so they are resumed before newer ones
+    for (const ActiveJob *active : active_jobs)
+        push_job(active->job);
+    for (const QueuedJob &job : pending_jobs)
+        push_job(job);
+
+    obs_data_set_array(data, "jobs", array);
+    obs_data_array_release(array);
+
+    if (!obs_data_save_json_safe(data, queue_path, "tmp", "bak"))
+        obs_log(LOG_WARNING, "Failed to save job queue to %s", queue_path);
+
+    obs_data_release(data);
+    bfree(queue_path);
+}
+
+static void load_queue()
+{
+    char *queue_path = obs_module_get_config_path(obs_current_module(), "job-queue.json");
+    if (!queue_path)
+        return;
+
+    obs_data_t *data = obs_data_create_from_json_file(queue_path);
+    bfree(queue_path);
+    if (!data)
+        return;
+
+    obs_data_array_t *array = obs_data_get_array(data, "jobs");
+    if (array) {
+        size_t count = obs_data_array_count(array);
+        for (size_t i = 0; i < count; i++) {
+            obs_data_t *item = obs_data_array_item(array, i);
+            if (item) {
+                QueuedJob job;
+                job.command = obs_data_get_string(item, "command");
+                job.argument = obs_data_get_string(item, "argument");
+                if (!job.command.empty())
+                    pending_jobs.push_back(job);
+                obs_data_release(item);
+            }
+        }
+        obs_data_array_release(array);
+    }
+    obs_data_release(data);
+
+    if (!pending_jobs.empty())
+        obs_log(LOG_INFO, "Restored %zu queued jobs", pending_jobs.size());
+}
+
+// Pauses or resumes a running job; queue_mutex must be held
+static void set_job_paused(ActiveJob *active, bool paused)
+{
+#ifdef _WIN32
+    // No supported way to suspend a process tree, running jobs are only deferred
+    (void)active;
+    (void)paused;
+#else
+    if (active->pid > 0)
+        kill(-active->pid, paused ? SIGSTOP : SIGCONT);
+#endif
+}
+
+static bool spawn_job(ActiveJob &active)
+{
+    const QueuedJob &job = active.job;
+
+#ifdef _WIN32
+    STARTUPINFOA si = {};
+    PROCESS_INFORMATION pi = {};
+    si.cb = sizeof(si);
+
+    std::string cmd = "\"" + job.command + "\"";
+    if (!job.argument.empty())
+        cmd += " \"" + job.argument + "\"";
+    std::vector<char> cmd_line(cmd.begin(), cmd.end());
+    cmd_line.push_back('\0');
+
+    // Suspended until it is in the job object, so children it starts right away are included
+    if (!CreateProcessA(nullptr, cmd_line.data(), nullptr, nullptr, FALSE,
+                        BELOW_NORMAL_PRIORITY_CLASS | CREATE_SUSPENDED, nullptr, nullptr, &si, &pi))
+        return false;
+
+    active.job_object = CreateJobObjectA(nullptr, nullptr);
+    if (active.job_object != nullptr) {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION jeli = {};
+        jeli.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+        SetInformationJobObject(active.job_object, JobObjectExtendedLimitInformation, &jeli, sizeof(jeli));
+        AssignProcessToJobObject(active.job_object, pi.hProcess);
+    }
+    ResumeThread(pi.hThread);
+
+    CloseHandle(pi.hThread);
+    active.process = pi.hProcess;
+    return true;
+#else
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Own process group so pausing and stopping reach the whole job
+        setpgid(0, 0);
+        if (job.argument.empty())
+            execl(job.command.c_str(), job.command.c_str(), (char *)nullptr);
+        else
+            execl(job.command.c_str(), job.command.c_str(), job.argument.c_str(), (char *)nullptr);
+        _exit(127);
+    }
+    if (pid < 0)
+        return false;
+
+    // Also set from the parent, so a signal sent to the group right after
+    // fork cannot arrive before the group exists
+    setpgid(pid, pid);
+    active.pid = pid;
+    return true;
+#endif
+}
+
+// Blocks until the job exits and returns its exit status; signaled is set
+// when a signal ended it
+static int wait_job(ActiveJob &active, bool &signaled)
+{
+#ifdef _WIN32
+    WaitForSingleObject(active.process, INFINITE);
+    DWORD exit_code = 0;
+    GetExitCodeProcess(active.process, &exit_code);
+    CloseHandle(active.process);
+    if (active.job_object != nullptr)
+        CloseHandle(active.job_object);
+    signaled = false;
+    return (int)exit_code;
+#else
+    int status = 0;
+    while (waitpid(active.pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+    signaled = WIFSIGNALED(status);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+#endif
+}
+
+static void worker_loop()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+
+    for (;;) {
+        queue_cv.wait(lock, [] { return queue_stopping || (!live && !pending_jobs.empty()); });
+        if (queue_stopping)
+            break;
+
+        ActiveJob active = {};
+        active.job = pending_jobs.front();
+        pending_jobs.pop_front();
+
+        if (!spawn_job(active)) {
+            obs_log(LOG_WARNING, "Failed to start job: %s", active.job.command.c_str());
+            save_queue();
+            continue;
+        }
+
+        // Registered under the lock so a concurrent live change cannot miss it
+        active_jobs.push_back(&active);
+        obs_log(LOG_INFO, "Started job: %s %s", active.job.command.c_str(), active.job.argument.c_str());
+
+        lock.unlock();
+        bool signaled = false;
+        int exit_status = wait_job(active, signaled);
+        lock.lock();
+
+        active_jobs.erase(std::find(active_jobs.begin(), active_jobs.end(), &active));
+        if (queue_stopping) {
+            queue_cv.notify_all();
+            // Interrupted by shutdown, keep it queued for the next session; a
+            // job that completed meanwhile must not run a second time
+            if (signaled || (active.stop_requested && exit_status != 0)) {
+                obs_log(LOG_INFO, "Job interrupted by shutdown, kept queued: %s", active.job.command.c_str());
+                pending_jobs.push_front(active.job);
+                break;
+            }
+        }
+
+        if (exit_status == 0)
+            obs_log(LOG_INFO, "Job finished: %s", active.job.command.c_str());
+        else
+            obs_log(LOG_WARNING, "Job failed with status %d: %s", exit_status, active.job.command.c_str());
+        save_queue();
+        if (queue_stopping)
+            break;
+    }
+}
+
+void job_queue_start()
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    if (queue_running)
+        return;
+
+    load_queue();
+    queue_running = true;
+    queue_stopping = false;
+    for (size_t i = 0; i < JOB_WORKER_COUNT; ++i)
+        workers.emplace_back(worker_loop);
+}
+
+void job_queue_stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (!queue_running)
+            return;
+
+        queue_stopping = true;
+        for (ActiveJob *active : active_jobs) {
+            active->stop_requested = true;
+#ifdef _WIN32
+            if (active->job_object != nullptr)
+                TerminateJobObject(active->job_object, 1);
+            else
+                TerminateProcess(active->process, 1);
+#else
+            kill(-active->pid, SIGTERM);
+            kill(-active->pid, SIGCONT);
+#endif
+        }
+        queue_cv.notify_all();
+
+        // Workers block until their job exits, so a job ignoring SIGTERM must not hold up OBS's exit
+        if (!queue_cv.wait_for(lock, JOB_STOP_GRACE, [] { return active_jobs.empty(); })) {
+            for (ActiveJob *active : active_jobs) {
+                obs_log(LOG_WARNING, "Job did not exit, killing it: %s", active->job.command.c_str());
+#ifndef _WIN32
+                kill(-active->pid, SIGKILL);
+#endif
+            }
+        }
+    }
+
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    save_queue();
+    queue_running = false;
+    obs_log(LOG_INFO, "Job queue stopped with %zu jobs left", pending_jobs.size());
+}
+
+void job_queue_set_live(bool is_live)
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (live == is_live)
+            return;
+
+        live = is_live;
+        for (ActiveJob *active : active_jobs)
+            set_job_paused(active, live);
+        if (!active_jobs.empty())
+            obs_log(LOG_INFO, "%s %zu running jobs", live ? "Paused" : "Resumed", active_jobs.size());
+    }
+    if (!is_live)
+        queue_cv.notify_all();
+}
+
+void job_queue_trigger(JobTrigger trigger, const char *output_path)
+{
+    std::vector<ExecutableConfig> configs = get_executable_configs();
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        for (const ExecutableConfig &config : configs) {
+            if (config.trigger != trigger || config.path.empty() || config.in_process)
+                continue;
+
+            pending_jobs.push_back({config.path, output_path ? output_path : ""});
+            obs_log(LOG_INFO, "Queued job%s: %s", live ? " (deferred until idle)" : "", config.path.c_str());
+            queued++;
+        }
+        if (queued)
+            save_queue();
+    }
+    if (queued)
+        queue_cv.notify_all();
+}
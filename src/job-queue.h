@@ -0,0 +1,29 @@
+/*
+OBS Starter Plugin - Deferred Job Queue
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#pragma once
+
+#include <plugin-support.h>
+
+// Names used for JobTrigger in config.json
+const char *job_trigger_to_string(JobTrigger trigger);
+JobTrigger job_trigger_from_string(const char *value);
+
+// Restores the persisted queue and starts the worker pool
+void job_queue_start();
+
+// Stops the workers; interrupted jobs stay queued for the next session
+void job_queue_stop();
+
+// While live (streaming or recording) no job is started and running jobs are paused
+void job_queue_set_live(bool live);
+
+// Queues every job entry bound to trigger, passing output_path as its argument
+void job_queue_trigger(JobTrigger trigger, const char *output_path);
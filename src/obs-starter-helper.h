@@ -0,0 +1,74 @@
+/*
+OBS Starter Plugin - In-process Helper ABI
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+/*
+ * C ABI for helpers that are loaded into OBS as a shared library instead of
+ * being started as a process. A helper exports OBS_STARTER_HELPER_ENTRY,
+ * which returns a static obs_starter_helper_api for the host ABI version.
+ *
+ * All callbacks run on one worker thread owned by the plugin. tick and event
+ * calls should return within host->tick_budget_ms; once should_stop returns
+ * nonzero the helper is expected to return as soon as possible. A helper
+ * that does not return at all is abandoned and its library stays loaded.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OBS_STARTER_HELPER_ABI_VERSION 1
+#define OBS_STARTER_HELPER_ENTRY "obs_starter_helper_get_api"
+
+enum obs_starter_helper_event_type {
+    OBS_STARTER_HELPER_EVENT_LOADED = 1, /* OBS has finished loading, also sent to helpers loaded later */
+    OBS_STARTER_HELPER_EVENT_STREAMING_STARTED = 2,
+    OBS_STARTER_HELPER_EVENT_STREAMING_STOPPED = 3,
+    OBS_STARTER_HELPER_EVENT_RECORDING_STARTED = 4,
+    OBS_STARTER_HELPER_EVENT_RECORDING_STOPPED = 5, /* path is the recording */
+    OBS_STARTER_HELPER_EVENT_REPLAY_SAVED = 6,      /* path is the saved replay */
+};
+
+struct obs_starter_helper_event {
+    uint32_t type;
+    /* Output file for the event or NULL, valid during the call only */
+    const char *path;
+};
+
+struct obs_starter_helper_host {
+    uint32_t abi_version;
+    uint32_t tick_budget_ms;
+    void *host_data;
+    /* level is an OBS log level: 100 error, 200 warning, 300 info, 400 debug */
+    void (*log)(void *host_data, int level, const char *message);
+    /* Nonzero once the current call is over budget or the helper is being stopped */
+    int (*should_stop)(void *host_data);
+};
+
+struct obs_starter_helper_api {
+    uint32_t abi_version;
+    /* Interval between tick calls, 0 for helpers that only react to events */
+    uint32_t tick_interval_ms;
+    /* Returns the helper state passed to the other callbacks, NULL on failure */
+    void *(*init)(const struct obs_starter_helper_host *host);
+    /* tick and event may be NULL; a nonzero return stops the helper */
+    int (*tick)(void *state);
+    int (*event)(void *state, const struct obs_starter_helper_event *event);
+    void (*shutdown)(void *state);
+};
+
+typedef const struct obs_starter_helper_api *(*obs_starter_helper_get_api_t)(uint32_t host_abi_version);
+
+#ifdef __cplusplus
+}
+#endif
@@ -23,19 +23,47 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QAction>
 #include <QDialog>
 #include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <chrono>
 #include <util/platform.h>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <process.h>
 #include <direct.h>
+#include <psapi.h>
 #else
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#endif
+
+#ifdef __APPLE__
+#include <libproc.h>
+#include <mach/mach_time.h>
+#include <crt_externs.h>
+#define environ (*_NSGetEnviron())
+#elif !defined(_WIN32)
+extern char **environ;
 #endif
 
 #include "config-dialog.h"
+#include "control-server.h"
+#include "inproc-helper.h"
+#include "job-queue.h"
+#include "prefetch.h"
+#include "preflight.h"
+#include "obs-starter-helper.h"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
@@ -47,139 +75,1216 @@ struct ProcessHandle {
     PROCESS_INFORMATION pi;
     HANDLE hJob;
 };
-static std::vector<ProcessHandle> running_processes;
+#endif
+
+// One process of a helper; entries with more than one replica form a group
+struct ReplicaRuntime {
+#ifdef _WIN32
+    ProcessHandle process = {{INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, 0, 0}, nullptr};
 #else
-static std::vector<pid_t> running_processes;
+    pid_t pid = 0;
+    // Read end of the exec-error pipe until the supervisor has confirmed the exec
+    int exec_pipe = -1;
+    uint64_t spawn_start_ns = 0;
+#endif
+    bool running = false;
+    int last_exit_status = -1;
+    uint64_t started_ns = 0;
+    // Replacement of a dead group member, with backoff against crash loops
+    uint64_t respawn_at_ns = 0;
+    uint64_t respawn_backoff_ns = 0;
+};
+
+// Runtime state of one configured executable, kept parallel to executable_configs
+struct HelperRuntime {
+    // Identifies the runtime while helpers_mutex is released, indices change with the configuration
+    uint64_t id = 0;
+    std::vector<ReplicaRuntime> replicas;
+    // Loaded helper library for in-process entries, which have no replicas
+    InProcessHelper *in_process = nullptr;
+    // Set while the library is being loaded without helpers_mutex, cleared to discard the load
+    bool in_process_loading = false;
+    uint64_t in_process_started_ns = 0;
+    int in_process_exit_status = -1;
+    // Set while the helper should be running, dead group members are only replaced then
+    bool wanted = false;
+    // Start handed to the supervisor by a caller that must not block, see start_pending_helpers
+    bool start_pending = false;
+    bool supervised = false;
+    unsigned int restarts = 0;
+    unsigned long long spawn_latency_buckets[SPAWN_LATENCY_BUCKET_COUNT] = {};
+    unsigned long long spawn_latency_count = 0;
+    double spawn_latency_sum = 0.0;
+};
+
+#ifndef _WIN32
+// Process group that got SIGTERM and is sent SIGKILL once its grace period is over
+struct PendingStop {
+    pid_t pid;
+    uint64_t kill_at_ns;
+    bool killed;
+    bool reaped;
+};
+static std::vector<PendingStop> pending_stops;
 #endif
 
+// In-process helper taken out of its runtime; unloading waits for its thread,
+// so it happens in flush_pending_unloads once helpers_mutex is released
+struct PendingUnload {
+    InProcessHelper *helper;
+    // Runtime that gets the exit status, 0 if it is already known
+    uint64_t runtime_id;
+};
+static std::vector<PendingUnload> pending_unloads;
+// Serializes flushes, so a flush returns only after earlier unloads are done
+static std::mutex unload_mutex;
+
+const double spawn_latency_bucket_bounds[SPAWN_LATENCY_BUCKET_COUNT] = {
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.1, 1.0
+};
+
+// Guards executable_configs, helpers, pending_stops and pending_unloads, which
+// are shared between the UI thread, the supervisor and the control server thread
+static std::mutex helpers_mutex;
+static std::vector<HelperRuntime> helpers;
 static std::vector<ExecutableConfig> executable_configs;
+static uint64_t last_runtime_id = 0;
+// Cores left to OBS itself when sizing and pinning "auto" replica groups
+static int obs_reserved_cores = 2;
+static uint64_t module_load_ns = 0;
+// Set once the last launch phase is done, until the ready time has been logged
+static bool helpers_ready_pending = false;
+// Set with OBS_STARTER_HELPER_EVENT_LOADED, in-process helpers loaded later get the event on their own
+static bool obs_finished_loading = false;
+
+static const uint64_t STOP_GRACE_NS = 500000000ULL;
+static const uint64_t RESPAWN_MIN_BACKOFF_NS = 1000000000ULL;
+static const uint64_t RESPAWN_MAX_BACKOFF_NS = 60000000000ULL;
+// A replica that lived this long is considered healthy and resets its backoff
+static const uint64_t RESPAWN_HEALTHY_NS = 10000000000ULL;
+
+static void record_spawn_latency(HelperRuntime &runtime, uint64_t latency_ns)
+{
+    double seconds = (double)latency_ns / 1e9;
+    for (size_t i = 0; i < SPAWN_LATENCY_BUCKET_COUNT; ++i) {
+        if (seconds <= spawn_latency_bucket_bounds[i])
+            runtime.spawn_latency_buckets[i]++;
+    }
+    runtime.spawn_latency_count++;
+    runtime.spawn_latency_sum += seconds;
+}
+
+static bool helper_running(const HelperRuntime &runtime)
+{
+    if (runtime.in_process_loading)
+        return true;
+    if (runtime.in_process)
+        return !inproc_helper_finished(runtime.in_process);
+    for (const ReplicaRuntime &replica : runtime.replicas) {
+        if (replica.running)
+            return true;
+    }
+    return false;
+}
+
+// Logical CPUs of one physical core, i.e. its SMT siblings
+typedef std::vector<int> PhysicalCore;
+
+#ifdef __linux__
+static int read_topology_value(int cpu, const char *name)
+{
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return -1;
+    int value = -1;
+    if (fscanf(file, "%d", &value) != 1)
+        value = -1;
+    fclose(file);
+    return value;
+}
+#endif
+
+// Physical cores OBS may run on, in order, with the CPUs of each that OBS may use
+static std::vector<PhysicalCore> available_cores()
+{
+    std::vector<PhysicalCore> cores;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        // SMT siblings share package and core id
+        std::vector<std::pair<int, int>> ids;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (!CPU_ISSET(cpu, &set))
+                continue;
+            std::pair<int, int> id(read_topology_value(cpu, "physical_package_id"),
+                                   read_topology_value(cpu, "core_id"));
+            // Without topology information every CPU counts as a core of its own
+            if (id.second < 0)
+                id = std::make_pair(-1, cpu);
+
+            size_t core = std::find(ids.begin(), ids.end(), id) - ids.begin();
+            if (core == ids.size()) {
+                ids.push_back(id);
+                cores.emplace_back();
+            }
+            cores[core].push_back(cpu);
+        }
+    }
+#elif defined(_WIN32)
+    DWORD_PTR process_mask = 0, system_mask = 0;
+    DWORD length = 0;
+    GetLogicalProcessorInformation(nullptr, &length);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) && !info.empty() &&
+        GetLogicalProcessorInformation(info.data(), &length)) {
+        for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION &entry : info) {
+            if (entry.Relationship != RelationProcessorCore)
+                continue;
+            PhysicalCore core;
+            for (int cpu = 0; cpu < (int)sizeof(DWORD_PTR) * 8; ++cpu) {
+                if (entry.ProcessorMask & process_mask & ((DWORD_PTR)1 << cpu))
+                    core.push_back(cpu);
+            }
+            if (!core.empty())
+                cores.push_back(core);
+        }
+    }
+#endif
+    if (cores.empty()) {
+        unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int cpu = 0; cpu < count; ++cpu)
+            cores.push_back({(int)cpu});
+    }
+    return cores;
+}
 
-static void start_executables()
+// Physical cores handed out to replicas: everything except the first ones,
+// which stay with OBS together with their SMT siblings
+static std::vector<PhysicalCore> worker_cores()
 {
-    // Clear any previous process handles
-    running_processes.clear();
+    std::vector<PhysicalCore> cores = available_cores();
+    size_t reserved = (size_t)std::max(obs_reserved_cores, 0);
+    if (cores.size() > reserved)
+        cores.erase(cores.begin(), cores.begin() + reserved);
+    else
+        cores.erase(cores.begin(), cores.end() - 1);
+    return cores;
+}
+
+static size_t replica_count(const ExecutableConfig &config)
+{
+    if (config.replicas > 0)
+        return (size_t)config.replicas;
+    // Auto: one replica per physical core not reserved for OBS
+    return std::max<size_t>(1, worker_cores().size());
+}
+
+static std::mutex supervisor_mutex;
+static std::condition_variable supervisor_cv;
+#ifndef _WIN32
+// Interrupts the supervisor's poll, it waits on this instead of supervisor_cv
+static int supervisor_wake_pipe[2] = {-1, -1};
+#endif
+
+// Starts a supervision round right away, e.g. when an exec pipe is added or
+// a start is handed over; helpers_mutex must be held
+static void wake_supervisor()
+{
+#ifdef _WIN32
+    supervisor_cv.notify_all();
+#else
+    if (supervisor_wake_pipe[1] < 0)
+        return;
+    char byte = 0;
+    ssize_t written = write(supervisor_wake_pipe[1], &byte, 1);
+    (void)written;
+#endif
+}
+
+#ifndef _WIN32
+
+// Signals the process group of pid, or pid alone if it has not called setsid
+// yet; once the child is reaped its pid may belong to an unrelated process,
+// so then only the group is signalled
+static void signal_group(pid_t pid, int sig, bool reaped)
+{
+    if (kill(-pid, sig) != 0 && errno == ESRCH && !reaped)
+        kill(pid, sig);
+}
+
+static bool create_cloexec_pipe(int fds[2])
+{
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0)
+        return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+#endif
+
+// Starts replica r of the executable at index, pinned to the CPUs of core
+// unless it is empty; helpers_mutex must be held
+static bool spawn_replica(size_t index, size_t r, size_t count, const PhysicalCore &core)
+{
+    const ExecutableConfig &config = executable_configs[index];
+    HelperRuntime &runtime = helpers[index];
+    ReplicaRuntime &replica = runtime.replicas[r];
+    uint64_t spawn_start = os_gettime_ns();
+
+    // Shard assignment for workers that split their input between replicas
+    std::string shard_index = "OBS_STARTER_SHARD_INDEX=" + std::to_string(r);
+    std::string shard_count = "OBS_STARTER_SHARD_COUNT=" + std::to_string(count);
+
+#ifdef _WIN32
+    STARTUPINFOA si = {};
+    PROCESS_INFORMATION pi = {};
+    si.cb = sizeof(si);
     
-    for (const auto &config : executable_configs) {
-        if (!config.path.empty()) {
+    // Set window state based on minimize option
+    if (config.start_minimized) {
+        si.dwFlags = STARTF_USESHOWWINDOW;
+        si.wShowWindow = SW_MINIMIZE;
+    }
+    
+    // Initialize to invalid values
+    pi.hProcess = INVALID_HANDLE_VALUE;
+    pi.hThread = INVALID_HANDLE_VALUE;
+    
+    // Create a writable buffer for CreateProcessA command line
+    std::vector<char> cmd_line(config.path.begin(), config.path.end());
+    cmd_line.push_back('\0');
+    
+    // Inherited environment plus the shard variables, as a double-null terminated block
+    std::vector<char> environment;
+    char *inherited = GetEnvironmentStringsA();
+    for (const char *entry = inherited; entry && *entry; entry += strlen(entry) + 1) {
+        if (strncmp(entry, "OBS_STARTER_SHARD_", 18) != 0)
+            environment.insert(environment.end(), entry, entry + strlen(entry) + 1);
+    }
+    if (inherited)
+        FreeEnvironmentStringsA(inherited);
+    environment.insert(environment.end(), shard_index.c_str(), shard_index.c_str() + shard_index.size() + 1);
+    environment.insert(environment.end(), shard_count.c_str(), shard_count.c_str() + shard_count.size() + 1);
+    environment.push_back('\0');
+    
+    // Suspended so the affinity is in place before the first instruction runs
+    if (CreateProcessA(nullptr, cmd_line.data(), nullptr, nullptr, 
+                     FALSE, CREATE_SUSPENDED, environment.data(), nullptr, &si, &pi)) {
+        
+        // Create a Job Object to ensure child processes (e.g. Python scripts, background processes)
+        // are terminated automatically when the parent or job handle closes.
+        HANDLE hJob = CreateJobObjectA(nullptr, nullptr);
+        if (hJob != nullptr) {
+            JOBOBJECT_EXTENDED_LIMIT_INFORMATION jeli = {};
+            jeli.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+            SetInformationJobObject(hJob, JobObjectExtendedLimitInformation, &jeli, sizeof(jeli));
+            AssignProcessToJobObject(hJob, pi.hProcess);
+        }
+        DWORD_PTR affinity = 0;
+        for (int cpu : core)
+            affinity |= cpu < (int)sizeof(DWORD_PTR) * 8 ? (DWORD_PTR)1 << cpu : 0;
+        if (affinity)
+            SetProcessAffinityMask(pi.hProcess, affinity);
+        ResumeThread(pi.hThread);
+        
+        replica.process.pi = pi;
+        replica.process.hJob = hJob;
+        replica.running = true;
+        replica.started_ns = os_gettime_ns();
+        record_spawn_latency(runtime, replica.started_ns - spawn_start);
+        obs_log(LOG_INFO, "Started executable%s: %s", 
+               config.start_minimized ? " (minimized)" : "", config.path.c_str());
+        return true;
+    }
+#else
+    // Environment is built before fork, the child must not allocate
+    std::vector<char *> envp;
+    for (char **entry = environ; *entry; ++entry) {
+        if (strncmp(*entry, "OBS_STARTER_SHARD_", 18) != 0)
+            envp.push_back(*entry);
+    }
+    envp.push_back(&shard_index[0]);
+    envp.push_back(&shard_count[0]);
+    envp.push_back(nullptr);
+    char *argv[] = {const_cast<char *>(config.path.c_str()), nullptr};
+
+#ifdef __linux__
+    cpu_set_t affinity;
+    CPU_ZERO(&affinity);
+    for (int cpu : core) {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &affinity);
+    }
+#endif
+
+    // The child reports a failed exec through this pipe; a successful exec
+    // closes it (CLOEXEC) and the parent reads EOF
+    int exec_pipe[2];
+    if (!create_cloexec_pipe(exec_pipe)) {
+        obs_log(LOG_WARNING, "Failed to start executable: %s (%s)", config.path.c_str(), strerror(errno));
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Child process: create new process group so child subprocesses are tracked together
+        setsid();
+#ifdef __linux__
+        if (CPU_COUNT(&affinity) > 0)
+            sched_setaffinity(0, sizeof(affinity), &affinity);
+#endif
+        execve(config.path.c_str(), argv, envp.data());
+        int exec_errno = errno;
+        ssize_t written = write(exec_pipe[1], &exec_errno, sizeof(exec_errno));
+        (void)written;
+        // _exit: the forked copy must not run OBS's atexit handlers or static destructors
+        _exit(1);
+    }
+
+    close(exec_pipe[1]);
+    if (pid > 0) {
+        // Parent process; exec may block on a cold disk, so the supervisor
+        // waits for the pipe without holding helpers_mutex (see confirm_exec)
+        fcntl(exec_pipe[0], F_SETFL, O_NONBLOCK);
+        replica.pid = pid;
+        replica.running = true;
+        replica.exec_pipe = exec_pipe[0];
+        replica.spawn_start_ns = spawn_start;
+        replica.started_ns = spawn_start;
+        wake_supervisor();
+        return true;
+    }
+    close(exec_pipe[0]);
+#endif
+
+    obs_log(LOG_WARNING, "Failed to start executable: %s", config.path.c_str());
+    return false;
+}
+
+#ifndef _WIN32
+// Completes the spawn of replica once its child has exec'd (EOF on the pipe)
+// or reported why it could not; helpers_mutex must be held
+static void confirm_exec(const ExecutableConfig &config, HelperRuntime &runtime, ReplicaRuntime &replica)
+{
+    int exec_errno = 0;
+    ssize_t reported = read(replica.exec_pipe, &exec_errno, sizeof(exec_errno));
+    if (reported < 0)
+        return;
+    close(replica.exec_pipe);
+    replica.exec_pipe = -1;
+
+    if (reported == sizeof(exec_errno)) {
+        // The child exits right after reporting
+        waitpid(replica.pid, nullptr, 0);
+        replica.pid = 0;
+        replica.running = false;
+        replica.last_exit_status = 127;
+        replica.respawn_at_ns = os_gettime_ns() + (replica.respawn_backoff_ns = RESPAWN_MAX_BACKOFF_NS);
+        obs_log(LOG_WARNING, "Failed to start executable: %s (%s)", config.path.c_str(), strerror(exec_errno));
+        return;
+    }
+
+    // The latency covers fork up to a completed exec
+    replica.started_ns = os_gettime_ns();
+    record_spawn_latency(runtime, replica.started_ns - replica.spawn_start_ns);
+    obs_log(LOG_INFO, "Started executable%s: %s", config.start_minimized ? " (minimize requested)" : "",
+            config.path.c_str());
+}
+#endif
+
+// Physical core for replica r, empty for plain single-process helpers which are not pinned
+static PhysicalCore replica_core(const HelperRuntime &runtime, const std::vector<PhysicalCore> &cores, size_t r)
+{
+    if (!runtime.supervised || cores.empty())
+        return PhysicalCore();
+    return cores[r % cores.size()];
+}
+
+// Unloads the in-process helpers taken out of their runtimes so far;
+// helpers_mutex must not be held
+static void flush_pending_unloads()
+{
+    std::lock_guard<std::mutex> flush_lock(unload_mutex);
+    std::vector<PendingUnload> unloads;
+    {
+        std::lock_guard<std::mutex> lock(helpers_mutex);
+        unloads.swap(pending_unloads);
+    }
+
+    for (const PendingUnload &unload : unloads) {
+        int exit_status = inproc_helper_unload(unload.helper);
+        if (!unload.runtime_id)
+            continue;
+        std::lock_guard<std::mutex> lock(helpers_mutex);
+        for (HelperRuntime &runtime : helpers) {
+            if (runtime.id == unload.runtime_id)
+                runtime.in_process_exit_status = exit_status;
+        }
+    }
+}
+
+// Loads the in-process helper at index with helpers_mutex released, since
+// dlopen and the library's constructors may block. lock must own helpers_mutex;
+// index is no longer valid once this returns.
+static bool load_in_process(std::unique_lock<std::mutex> &lock, size_t index)
+{
+    HelperRuntime &runtime = helpers[index];
+    uint64_t id = runtime.id;
+    std::string path = executable_configs[index].path;
+    runtime.in_process_loading = true;
+    runtime.wanted = true;
+
+    lock.unlock();
+    // A previous instance of the library must be gone before it is loaded again
+    flush_pending_unloads();
+    uint64_t load_start = os_gettime_ns();
+    InProcessHelper *helper = inproc_helper_load(path);
+    uint64_t loaded = os_gettime_ns();
+    lock.lock();
+
+    // The entry may have been stopped, edited or removed meanwhile
+    auto it = std::find_if(helpers.begin(), helpers.end(),
+                           [id](const HelperRuntime &candidate) { return candidate.id == id; });
+    bool still_wanted = it != helpers.end() && it->in_process_loading;
+    if (still_wanted) {
+        it->in_process_loading = false;
+        it->wanted = helper != nullptr;
+    }
+    if (!helper)
+        return false;
+    if (!still_wanted) {
+        pending_unloads.push_back({helper, 0});
+        return false;
+    }
+
+    it->in_process = helper;
+    it->in_process_started_ns = loaded;
+    record_spawn_latency(*it, loaded - load_start);
+    if (obs_finished_loading)
+        inproc_helper_post_event(helper, OBS_STARTER_HELPER_EVENT_LOADED, nullptr);
+    return true;
+}
+
+// Starts every replica of the executable at index that is not running;
+// helpers_mutex must be held
+static bool spawn_executable(size_t index)
+{
+    const ExecutableConfig &config = executable_configs[index];
+    HelperRuntime &runtime = helpers[index];
+
+    size_t count = replica_count(config);
+    std::vector<PhysicalCore> cores = worker_cores();
+
+    runtime.replicas.resize(count);
+    runtime.supervised = count > 1 || config.replicas == 0;
+    runtime.wanted = true;
+
+    bool all_started = true;
+    for (size_t r = 0; r < count; ++r) {
+        ReplicaRuntime &replica = runtime.replicas[r];
+        if (replica.running)
+            continue;
+        replica.respawn_backoff_ns = 0;
+        if (!spawn_replica(index, r, count, replica_core(runtime, cores, r)))
+            all_started = false;
+    }
+    if (runtime.supervised)
+        obs_log(LOG_INFO, "Replica group %s: %zu replicas on %zu worker cores", config.path.c_str(), count,
+                cores.size());
+    return all_started;
+}
+
+// Starts the helper at index, which must not be running; in-process
+// helpers are loaded with the lock released
+static bool start_executable(std::unique_lock<std::mutex> &lock, size_t index)
+{
+    if (executable_configs[index].path.empty())
+        return false;
+    if (executable_configs[index].in_process)
+        return load_in_process(lock, index);
+    return spawn_executable(index);
+}
+
+// Terminates all replicas of the executable at index. With wait set the call
+// blocks until the process trees are gone, otherwise SIGKILL is left to the
+// supervisor. helpers_mutex must be held.
+static void terminate_executable(size_t index, bool wait)
+{
+    HelperRuntime &runtime = helpers[index];
+    runtime.wanted = false;
+    runtime.start_pending = false;
+
+    // In-process helpers are unloaded by flush_pending_unloads, a pending load is discarded
+    runtime.in_process_loading = false;
+    if (runtime.in_process) {
+        pending_unloads.push_back({runtime.in_process, runtime.id});
+        runtime.in_process = nullptr;
+    }
+
+#ifdef _WIN32
+    for (ReplicaRuntime &replica : runtime.replicas) {
+        replica.running = false;
+        if (replica.process.pi.hProcess == INVALID_HANDLE_VALUE)
+            continue;
+        
+        // First terminate the job object if present.
+        // This forcefully terminates the main process AND all child processes (Python workers, sub-shells, etc.)
+        if (replica.process.hJob != nullptr) {
+            TerminateJobObject(replica.process.hJob, 0);
+            CloseHandle(replica.process.hJob);
+            replica.process.hJob = nullptr;
+        }
+        
+        TerminateProcess(replica.process.pi.hProcess, 0);
+        if (wait)
+            WaitForSingleObject(replica.process.pi.hProcess, 1000); // Reduced timeout for shutdown
+        CloseHandle(replica.process.pi.hProcess);
+        CloseHandle(replica.process.pi.hThread);
+        replica.process.pi.hProcess = INVALID_HANDLE_VALUE;
+        replica.process.pi.hThread = INVALID_HANDLE_VALUE;
+    }
+#else
+    // Kill process groups (-pid) to ensure child subprocesses are also killed;
+    // all replicas share one grace period
+    std::vector<pid_t> pids;
+    for (ReplicaRuntime &replica : runtime.replicas) {
+        replica.running = false;
+        if (replica.exec_pipe >= 0) {
+            close(replica.exec_pipe);
+            replica.exec_pipe = -1;
+        }
+        if (replica.pid > 0) {
+            signal_group(replica.pid, SIGTERM, false);
+            pids.push_back(replica.pid);
+        }
+        replica.pid = 0;
+    }
+    if (pids.empty())
+        return;
+
+    if (wait) {
+        usleep(500000); // 0.5 second wait
+        for (pid_t pid : pids) {
+            signal_group(pid, SIGKILL, false);
+            waitpid(pid, nullptr, WNOHANG);
+        }
+    } else {
+        for (pid_t pid : pids)
+            pending_stops.push_back({pid, os_gettime_ns() + STOP_GRACE_NS, false, false});
+    }
+#endif
+}
+
+// Notices a replica that exited on its own; helpers_mutex must be held
+static bool reap_replica(ReplicaRuntime &replica)
+{
+    if (!replica.running)
+        return false;
+
+#ifdef _WIN32
+    if (WaitForSingleObject(replica.process.pi.hProcess, 0) != WAIT_OBJECT_0)
+        return false;
+
+    DWORD exit_code = 0;
+    GetExitCodeProcess(replica.process.pi.hProcess, &exit_code);
+    replica.last_exit_status = (int)exit_code;
+    if (replica.process.hJob != nullptr) {
+        CloseHandle(replica.process.hJob);
+        replica.process.hJob = nullptr;
+    }
+    CloseHandle(replica.process.pi.hProcess);
+    CloseHandle(replica.process.pi.hThread);
+    replica.process.pi.hProcess = INVALID_HANDLE_VALUE;
+    replica.process.pi.hThread = INVALID_HANDLE_VALUE;
+#else
+    // A failed exec is reported by confirm_exec, not as an exit
+    int status = 0;
+    if (replica.exec_pipe >= 0 || waitpid(replica.pid, &status, WNOHANG) != replica.pid)
+        return false;
+
+    replica.last_exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    replica.pid = 0;
+#endif
+    replica.running = false;
+    return true;
+}
+
+// Notices replicas that exited and schedules replacements for supervised
+// groups; helpers_mutex must be held
+static void reap_helper(HelperRuntime &runtime)
+{
+    if (runtime.in_process && inproc_helper_finished(runtime.in_process)) {
+        runtime.in_process_exit_status = inproc_helper_exit_status(runtime.in_process);
+        pending_unloads.push_back({runtime.in_process, 0});
+        runtime.in_process = nullptr;
+    }
+
+    uint64_t now = os_gettime_ns();
+    for (ReplicaRuntime &replica : runtime.replicas) {
+        if (!reap_replica(replica) || !runtime.supervised || !runtime.wanted)
+            continue;
+
+        bool healthy = now - replica.started_ns >= RESPAWN_HEALTHY_NS;
+        replica.respawn_backoff_ns = healthy ? RESPAWN_MIN_BACKOFF_NS
+                                             : std::min(std::max(replica.respawn_backoff_ns * 2, RESPAWN_MIN_BACKOFF_NS),
+                                                        RESPAWN_MAX_BACKOFF_NS);
+        replica.respawn_at_ns = now + replica.respawn_backoff_ns;
+    }
+}
+
+// Reports when the last helper started by the launch phases was up, once
+// every pending exec is confirmed; helpers_mutex must be held
+static void log_helpers_ready_locked()
+{
+    if (!helpers_ready_pending)
+        return;
+
+    size_t running = 0;
+    uint64_t last_ready = 0;
+    for (const HelperRuntime &runtime : helpers) {
+        if (runtime.in_process_loading)
+            return;
+        if (!helper_running(runtime))
+            continue;
+        running++;
+        last_ready = std::max(last_ready, runtime.in_process ? runtime.in_process_started_ns : 0);
+        for (const ReplicaRuntime &replica : runtime.replicas) {
+#ifndef _WIN32
+            if (replica.exec_pipe >= 0)
+                return;
+#endif
+            if (replica.running)
+                last_ready = std::max(last_ready, replica.started_ns);
+        }
+    }
+    helpers_ready_pending = false;
+    if (running)
+        obs_log(LOG_INFO, "All %zu helpers ready %.1f ms after plugin load", running,
+                (double)(last_ready - module_load_ns) / 1e6);
+}
+
+static void supervise_helpers_locked()
+{
+    uint64_t now = os_gettime_ns();
+    for (size_t i = 0; i < helpers.size(); ++i) {
+        HelperRuntime &runtime = helpers[i];
+#ifndef _WIN32
+        for (ReplicaRuntime &replica : runtime.replicas) {
+            if (replica.exec_pipe >= 0)
+                confirm_exec(executable_configs[i], runtime, replica);
+        }
+#endif
+        reap_helper(runtime);
+        if (!runtime.supervised || !runtime.wanted)
+            continue;
+
+        // Replace dead group members, the others keep running untouched
+        std::vector<PhysicalCore> cores;
+        for (size_t r = 0; r < runtime.replicas.size(); ++r) {
+            ReplicaRuntime &replica = runtime.replicas[r];
+            if (replica.running || now < replica.respawn_at_ns)
+                continue;
+            if (cores.empty())
+                cores = worker_cores();
+
+            obs_log(LOG_INFO, "Replacing replica %zu of %s (exit status %d)", r, executable_configs[i].path.c_str(),
+                    replica.last_exit_status);
+            runtime.restarts++;
+            if (!spawn_replica(i, r, runtime.replicas.size(), replica_core(runtime, cores, r)))
+                replica.respawn_at_ns = now + (replica.respawn_backoff_ns = RESPAWN_MAX_BACKOFF_NS);
+        }
+    }
+
+#ifndef _WIN32
+    for (auto it = pending_stops.begin(); it != pending_stops.end();) {
+        if (!it->reaped) {
+            pid_t result = waitpid(it->pid, nullptr, WNOHANG);
+            it->reaped = result == it->pid || result < 0;
+        }
+        if (!it->killed && now >= it->kill_at_ns) {
+            signal_group(it->pid, SIGKILL, it->reaped);
+            it->killed = true;
+        }
+        it = (it->killed && it->reaped) ? pending_stops.erase(it) : it + 1;
+    }
+#endif
+
+    log_helpers_ready_locked();
+}
+
+// Reaping, replica replacement and SIGKILL escalation run on their own
+// thread so they work whether or not the control API is available
+static std::thread supervisor_thread;
+static bool supervisor_running = false;
+static const auto SUPERVISE_INTERVAL = std::chrono::milliseconds(100);
+
+#ifndef _WIN32
+// Sleeps until the next supervision round, returning early when an exec pipe
+// becomes readable so spawn latency is measured when the exec completes
+static void wait_for_exec_pipes()
+{
+    std::vector<struct pollfd> fds;
+    {
+        std::lock_guard<std::mutex> lock(helpers_mutex);
+        for (const HelperRuntime &runtime : helpers) {
+            for (const ReplicaRuntime &replica : runtime.replicas) {
+                if (replica.exec_pipe >= 0)
+                    fds.push_back({replica.exec_pipe, POLLIN, 0});
+            }
+        }
+    }
+    fds.push_back({supervisor_wake_pipe[0], POLLIN, 0});
+
+    // A pipe closed meanwhile by terminate_executable only causes an early
+    // round, confirm_exec reads whatever pipe the replica has then
+    poll(fds.data(), (nfds_t)fds.size(), (int)SUPERVISE_INTERVAL.count());
+
+    char drain[64];
+    while (read(supervisor_wake_pipe[0], drain, sizeof(drain)) > 0) {
+    }
+}
+#endif
+
+// Starts the helpers whose start was handed to the supervisor;
+// helpers_mutex must not be held
+static void start_pending_helpers()
+{
+    std::unique_lock<std::mutex> lock(helpers_mutex);
+    for (;;) {
+        auto it = std::find_if(helpers.begin(), helpers.end(),
+                               [](const HelperRuntime &runtime) { return runtime.start_pending; });
+        if (it == helpers.end())
+            return;
+        it->start_pending = false;
+        reap_helper(*it);
+        // start_executable may release the lock, so the search starts over
+        if (!helper_running(*it))
+            start_executable(lock, (size_t)(it - helpers.begin()));
+    }
+}
+
+static void supervisor_loop()
+{
+    std::unique_lock<std::mutex> lock(supervisor_mutex);
+    while (supervisor_running) {
+#ifdef _WIN32
+        supervisor_cv.wait_for(lock, SUPERVISE_INTERVAL);
+#else
+        lock.unlock();
+        wait_for_exec_pipes();
+        lock.lock();
+#endif
+        {
+            std::lock_guard<std::mutex> helpers_lock(helpers_mutex);
+            supervise_helpers_locked();
+        }
+        lock.unlock();
+        flush_pending_unloads();
+        start_pending_helpers();
+        lock.lock();
+    }
+}
+
+static void start_supervisor()
+{
+    std::lock_guard<std::mutex> lock(supervisor_mutex);
+    if (supervisor_running)
+        return;
+#ifndef _WIN32
+    if (!create_cloexec_pipe(supervisor_wake_pipe)) {
+        obs_log(LOG_ERROR, "Failed to create supervisor pipe (%s)", strerror(errno));
+        return;
+    }
+    fcntl(supervisor_wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(supervisor_wake_pipe[1], F_SETFL, O_NONBLOCK);
+#endif
+    supervisor_running = true;
+    supervisor_thread = std::thread(supervisor_loop);
+}
+
+static void stop_supervisor()
+{
+    {
+        std::lock_guard<std::mutex> lock(supervisor_mutex);
+        supervisor_running = false;
+    }
 #ifdef _WIN32
-            STARTUPINFOA si = {};
-            PROCESS_INFORMATION pi = {};
-            si.cb = sizeof(si);
-            
-            // Set window state based on minimize option
-            if (config.start_minimized) {
-                si.dwFlags = STARTF_USESHOWWINDOW;
-                si.wShowWindow = SW_MINIMIZE;
+    supervisor_cv.notify_all();
+#else
+    {
+        std::lock_guard<std::mutex> lock(helpers_mutex);
+        wake_supervisor();
+    }
+#endif
+    if (supervisor_thread.joinable())
+        supervisor_thread.join();
+
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(helpers_mutex);
+    if (supervisor_wake_pipe[0] >= 0) {
+        close(supervisor_wake_pipe[0]);
+        close(supervisor_wake_pipe[1]);
+        supervisor_wake_pipe[0] = supervisor_wake_pipe[1] = -1;
+    }
+#endif
+}
+
+#ifdef _WIN32
+static void sample_process_usage(long long pid, double &cpu_seconds, unsigned long long &rss_bytes)
+{
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)pid);
+    if (!process)
+        return;
+
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(process, &creation, &exit, &kernel, &user)) {
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        cpu_seconds += (double)(k.QuadPart + u.QuadPart) / 1e7;
+    }
+
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(process, &counters, sizeof(counters)))
+        rss_bytes += counters.WorkingSetSize;
+
+    CloseHandle(process);
+}
+#elif defined(__APPLE__)
+static void sample_process_usage(long long pid, double &cpu_seconds, unsigned long long &rss_bytes)
+{
+    struct proc_taskinfo info = {};
+    if (proc_pidinfo((pid_t)pid, PROC_PIDTASKINFO, 0, &info, sizeof(info)) != sizeof(info))
+        return;
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    double ticks = (double)(info.pti_total_user + info.pti_total_system);
+    cpu_seconds += ticks * timebase.numer / timebase.denom / 1e9;
+    rss_bytes += info.pti_resident_size;
+}
+#else
+static void sample_process_usage(long long pid, double &cpu_seconds, unsigned long long &rss_bytes)
+{
+    char stat_path[64];
+    snprintf(stat_path, sizeof(stat_path), "/proc/%lld/stat", pid);
+    FILE *file = fopen(stat_path, "r");
+    if (!file)
+        return;
+
+    char buffer[1024];
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    buffer[length] = '\0';
+
+    // The command name may contain spaces, so fields are counted from the last ')'
+    const char *fields = strrchr(buffer, ')');
+    if (!fields)
+        return;
+
+    unsigned long long utime = 0, stime = 0;
+    long long rss_pages = 0;
+    if (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %*d %*d %*d %*d %*d %*d %*u %*u %lld",
+               &utime, &stime, &rss_pages) != 3)
+        return;
+
+    cpu_seconds += (double)(utime + stime) / (double)sysconf(_SC_CLK_TCK);
+    rss_bytes += rss_pages > 0 ? (unsigned long long)rss_pages * (unsigned long long)sysconf(_SC_PAGESIZE) : 0;
+}
+#endif
+
+std::vector<HelperStatus> get_helper_statuses()
+{
+    std::vector<HelperStatus> statuses;
+    {
+        std::lock_guard<std::mutex> lock(helpers_mutex);
+        supervise_helpers_locked();
+
+        uint64_t now = os_gettime_ns();
+        statuses.reserve(helpers.size());
+        for (size_t i = 0; i < helpers.size(); ++i) {
+            const HelperRuntime &runtime = helpers[i];
+            HelperStatus status = {};
+            status.index = i;
+            status.path = executable_configs[i].path;
+            status.replicas = (unsigned int)runtime.replicas.size();
+            status.last_exit_status = runtime.in_process_exit_status;
+            for (const ReplicaRuntime &replica : runtime.replicas) {
+                if (replica.last_exit_status != -1)
+                    status.last_exit_status = replica.last_exit_status;
+                if (!replica.running)
+                    continue;
+#ifdef _WIN32
+                status.replica_pids.push_back((long long)replica.process.pi.dwProcessId);
+#else
+                status.replica_pids.push_back(replica.pid);
+#endif
+                // Uptime of the group is that of its oldest member
+                status.uptime_seconds = std::max(status.uptime_seconds, (double)(now - replica.started_ns) / 1e9);
             }
-            
-            // Initialize to invalid values
-            pi.hProcess = INVALID_HANDLE_VALUE;
-            pi.hThread = INVALID_HANDLE_VALUE;
-            
-            // Create a writable buffer for CreateProcessA command line
-            std::vector<char> cmd_line(config.path.begin(), config.path.end());
-            cmd_line.push_back('\0');
-            
-            if (CreateProcessA(nullptr, cmd_line.data(), nullptr, nullptr, 
-                             FALSE, 0, nullptr, nullptr, &si, &pi)) {
-                
-                // Create a Job Object to ensure child processes (e.g. Python scripts, background processes)
-                // are terminated automatically when the parent or job handle closes.
-                HANDLE hJob = CreateJobObjectA(nullptr, nullptr);
-                if (hJob != nullptr) {
-                    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jeli = {};
-                    jeli.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
-                    SetInformationJobObject(hJob, JobObjectExtendedLimitInformation, &jeli, sizeof(jeli));
-                    AssignProcessToJobObject(hJob, pi.hProcess);
+            if (runtime.in_process)
+                status.uptime_seconds = (double)(now - runtime.in_process_started_ns) / 1e9;
+            status.running = !status.replica_pids.empty() || runtime.in_process || runtime.in_process_loading;
+            status.pid = status.replica_pids.empty() ? 0 : status.replica_pids[0];
+            status.restarts = runtime.restarts;
+            memcpy(status.spawn_latency_buckets, runtime.spawn_latency_buckets,
+                   sizeof(status.spawn_latency_buckets));
+            status.spawn_latency_count = runtime.spawn_latency_count;
+            status.spawn_latency_sum = runtime.spawn_latency_sum;
+            statuses.push_back(status);
+        }
+    }
+
+    flush_pending_unloads();
+
+    // Sampling reads from the OS, so it happens outside the lock
+    for (HelperStatus &status : statuses) {
+        for (long long pid : status.replica_pids)
+            sample_process_usage(pid, status.cpu_seconds, status.rss_bytes);
+    }
+    return statuses;
+}
+
+HelperControlResult start_helper(size_t index)
+{
+    std::unique_lock<std::mutex> lock(helpers_mutex);
+    if (index >= helpers.size() || executable_configs[index].trigger != JobTrigger::None)
+        return HelperControlResult::NoSuchHelper;
+
+    reap_helper(helpers[index]);
+    if (helper_running(helpers[index]))
+        return HelperControlResult::AlreadyRunning;
+    helpers[index].start_pending = false;
+    if (!start_executable(lock, index))
+        return HelperControlResult::SpawnFailed;
+    return HelperControlResult::Ok;
+}
+
+HelperControlResult stop_helper(size_t index)
+{
+    std::lock_guard<std::mutex> lock(helpers_mutex);
+    if (index >= helpers.size())
+        return HelperControlResult::NoSuchHelper;
+
+    reap_helper(helpers[index]);
+    if (!helper_running(helpers[index]) && !helpers[index].wanted)
+        return HelperControlResult::NotRunning;
+
+    terminate_executable(index, false);
+    obs_log(LOG_INFO, "Stopped executable at index %zu", index);
+    return HelperControlResult::Ok;
+}
+
+HelperControlResult restart_helper(size_t index)
+{
+    std::unique_lock<std::mutex> lock(helpers_mutex);
+    if (index >= helpers.size() || executable_configs[index].trigger != JobTrigger::None)
+        return HelperControlResult::NoSuchHelper;
+
+    reap_helper(helpers[index]);
+    terminate_executable(index, false);
+
+    helpers[index].restarts++;
+    if (!start_executable(lock, index))
+        return HelperControlResult::SpawnFailed;
+    return HelperControlResult::Ok;
+}
+
+static const char *launch_phase_name(LaunchPhase phase)
+{
+    switch (phase) {
+    case LaunchPhase::Early:
+        return "early";
+    case LaunchPhase::Idle:
+        return "idle";
+    default:
+        return "after_load";
+    }
+}
+
+static LaunchPhase launch_phase_from_name(const char *name)
+{
+    if (name && strcmp(name, "early") == 0)
+        return LaunchPhase::Early;
+    if (name && strcmp(name, "idle") == 0)
+        return LaunchPhase::Idle;
+    return LaunchPhase::AfterLoad;
+}
+
+// Launch phases run on their own threads so neither plugin load nor the
+// FINISHED_LOADING callback wait for fork/exec
+static std::mutex launcher_mutex;
+static std::condition_variable launcher_cv;
+static std::vector<std::thread> launcher_threads;
+static bool launchers_cancelled = false;
+// Early, AfterLoad and Idle each run once per session
+static int launch_phases_remaining = 3;
+
+// OBS counts as idle while its process uses less than this share of one core
+static const double IDLE_CPU_PERCENT = 20.0;
+static const auto IDLE_SAMPLE_INTERVAL = std::chrono::milliseconds(250);
+// Idle-phase helpers start regardless once OBS has not become idle this long after their due time
+static const uint64_t IDLE_MAX_EXTRA_WAIT_NS = 60000000000ULL;
+
+// Starts the helper at index if it still belongs to phase and is not running
+static bool launch_helper(size_t index, LaunchPhase phase)
+{
+    std::unique_lock<std::mutex> lock(helpers_mutex);
+    if (index >= executable_configs.size())
+        return false;
+
+    const ExecutableConfig &config = executable_configs[index];
+    if (config.path.empty() || config.trigger != JobTrigger::None || config.launch_phase != phase)
+        return false;
+
+    reap_helper(helpers[index]);
+    return !helper_running(helpers[index]) && start_executable(lock, index);
+}
+
+static void start_executables(LaunchPhase phase)
+{
+    uint64_t phase_start = os_gettime_ns();
+    std::vector<ExecutableConfig> configs = get_executable_configs();
+    size_t started = 0;
+
+    if (phase != LaunchPhase::Idle) {
+        for (size_t i = 0; i < configs.size(); ++i)
+            started += launch_helper(i, phase) ? 1 : 0;
+    } else {
+        // Shortest required idle time first
+        std::vector<std::pair<int, size_t>> order;
+        for (size_t i = 0; i < configs.size(); ++i) {
+            if (configs[i].launch_phase == LaunchPhase::Idle)
+                order.emplace_back(std::max(configs[i].launch_delay, 0), i);
+        }
+        std::sort(order.begin(), order.end());
+
+        // Idleness is judged from OBS's own CPU use, which stays high while
+        // scenes, sources and browser docks are still being set up
+        os_cpu_usage_info_t *cpu_info = os_cpu_usage_info_start();
+        double cores = std::max(os_get_logical_cores(), 1);
+        uint64_t idle_since = phase_start;
+        size_t next = 0;
+        while (next < order.size()) {
+            {
+                std::unique_lock<std::mutex> lock(launcher_mutex);
+                if (launcher_cv.wait_for(lock, IDLE_SAMPLE_INTERVAL, [] { return launchers_cancelled; })) {
+                    os_cpu_usage_info_destroy(cpu_info);
+                    return;
                 }
-                
-                ProcessHandle ph;
-                ph.pi = pi;
-                ph.hJob = hJob;
-                running_processes.push_back(ph);
-                obs_log(LOG_INFO, "Started executable%s: %s", 
-                       config.start_minimized ? " (minimized)" : "", config.path.c_str());
-            } else {
-                obs_log(LOG_WARNING, "Failed to start executable: %s", config.path.c_str());
             }
-#else
-            pid_t pid = fork();
-            if (pid == 0) {
-                // Child process: create new process group so child subprocesses are tracked together
-                setsid();
-                execl(config.path.c_str(), config.path.c_str(), (char *)nullptr);
-                exit(1);
-            } else if (pid > 0) {
-                // Parent process
-                running_processes.push_back(pid);
-                obs_log(LOG_INFO, "Started executable%s: %s", 
-                       config.start_minimized ? " (minimize requested)" : "", config.path.c_str());
-            } else {
-                obs_log(LOG_WARNING, "Failed to start executable: %s", config.path.c_str());
+
+            uint64_t now = os_gettime_ns();
+            if (os_cpu_usage_info_query(cpu_info) * cores > IDLE_CPU_PERCENT)
+                idle_since = now;
+
+            while (next < order.size()) {
+                uint64_t required_ns = (uint64_t)order[next].first * 1000000000ULL;
+                bool idle = now - idle_since >= required_ns;
+                if (!idle && now - phase_start < required_ns + IDLE_MAX_EXTRA_WAIT_NS)
+                    break;
+                if (!idle)
+                    obs_log(LOG_INFO, "OBS did not become idle, starting %s anyway",
+                            configs[order[next].second].path.c_str());
+                started += launch_helper(order[next].second, phase) ? 1 : 0;
+                next++;
             }
-#endif
         }
+        os_cpu_usage_info_destroy(cpu_info);
+    }
+
+    if (started) {
+        uint64_t now = os_gettime_ns();
+        obs_log(LOG_INFO, "Launch phase %s started %zu executables in %.1f ms (%.1f ms after plugin load)",
+                launch_phase_name(phase), started, (double)(now - phase_start) / 1e6,
+                (double)(now - module_load_ns) / 1e6);
+    }
+
+    bool last_phase;
+    {
+        std::lock_guard<std::mutex> lock(launcher_mutex);
+        last_phase = --launch_phases_remaining == 0;
+    }
+    if (last_phase) {
+        std::lock_guard<std::mutex> lock(helpers_mutex);
+        helpers_ready_pending = true;
+        log_helpers_ready_locked();
     }
 }
 
+static void start_launch_phase(LaunchPhase phase)
+{
+    std::lock_guard<std::mutex> lock(launcher_mutex);
+    if (launchers_cancelled)
+        return;
+    launcher_threads.emplace_back(start_executables, phase);
+}
+
+// Aborts pending launches; must run before helpers are stopped so none starts afterwards
+static void cancel_launch_phases()
+{
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(launcher_mutex);
+        launchers_cancelled = true;
+        threads.swap(launcher_threads);
+    }
+    launcher_cv.notify_all();
+
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
 static void stop_executables()
 {
-    // Create a safe copy of the size to avoid accessing potentially corrupted vectors
-    size_t process_count = running_processes.size();
-    size_t config_count = executable_configs.size();
+    std::unique_lock<std::mutex> lock(helpers_mutex);
+    size_t process_count = helpers.size();
     
     obs_log(LOG_INFO, "Stopping %zu processes...", process_count);
     
     for (size_t i = 0; i < process_count; ++i) {
+        // No replacements for replicas that die while OBS shuts down
+        helpers[i].wanted = false;
+        helpers[i].start_pending = false;
+        reap_helper(helpers[i]);
+        if (!helper_running(helpers[i]))
+            continue;
+
         // Safety check: only proceed if we have valid config
-        bool should_shutdown = (i < config_count) ? executable_configs[i].shutdown_enabled : true;
+        bool should_shutdown = (i < executable_configs.size()) ? executable_configs[i].shutdown_enabled : true;
+        // In-process helpers live in OBS's address space and cannot outlive it
+        should_shutdown = should_shutdown || helpers[i].in_process || helpers[i].in_process_loading;
         
         if (should_shutdown) {
-#ifdef _WIN32
-            if (running_processes[i].pi.hProcess != INVALID_HANDLE_VALUE) {
-                try {
-                    // First terminate the job object if present.
-                    // This forcefully terminates the main process AND all child processes (Python workers, sub-shells, etc.)
-                    if (running_processes[i].hJob != nullptr) {
-                        TerminateJobObject(running_processes[i].hJob, 0);
-                        CloseHandle(running_processes[i].hJob);
-                        running_processes[i].hJob = nullptr;
-                    }
-                    
-                    TerminateProcess(running_processes[i].pi.hProcess, 0);
-                    WaitForSingleObject(running_processes[i].pi.hProcess, 1000); // Reduced timeout for shutdown
-                    CloseHandle(running_processes[i].pi.hProcess);
-                    CloseHandle(running_processes[i].pi.hThread);
-                    
-                    // Safe logging without accessing potentially corrupted config
-                    obs_log(LOG_INFO, "Stopped executable at index %zu", i);
-                } catch (...) {
-                    obs_log(LOG_ERROR, "Exception while stopping process %zu", i);
-                }
+            try {
+                terminate_executable(i, true);
+                obs_log(LOG_INFO, "Stopped executable at index %zu", i);
+            } catch (...) {
+                obs_log(LOG_ERROR, "Exception while stopping process %zu", i);
             }
-#else
-            if (running_processes[i] > 0) {
-                try {
-                    // Kill process group (-pid) to ensure child subprocesses are also killed
-                    kill(-running_processes[i], SIGTERM);
-                    usleep(500000); // 0.5 second wait
-                    kill(-running_processes[i], SIGKILL);
-                    obs_log(LOG_INFO, "Stopped executable at index %zu", i);
-                } catch (...) {
-                    obs_log(LOG_ERROR, "Exception while stopping process %zu", i);
-                }
+        } else {
+            // Left running on purpose, just forget about it
+#ifndef _WIN32
+            for (ReplicaRuntime &replica : helpers[i].replicas) {
+                if (replica.exec_pipe >= 0)
+                    close(replica.exec_pipe);
             }
 #endif
+            helpers[i] = HelperRuntime();
         }
     }
-    
-    // Clear the vectors safely
-    try {
-        running_processes.clear();
-        obs_log(LOG_INFO, "Cleared process list");
-    } catch (...) {
-        obs_log(LOG_ERROR, "Exception while clearing process list");
-    }
+
+    lock.unlock();
+    flush_pending_unloads();
 }
 
 static void load_settings()
@@ -194,6 +1299,9 @@ static void load_settings()
         return;
     }
         
+    obs_data_set_default_int(data, "obs_reserved_cores", obs_reserved_cores);
+    obs_reserved_cores = (int)obs_data_get_int(data, "obs_reserved_cores");
+
     obs_data_array_t *array = obs_data_get_array(data, "executables");
     if (!array) {
         obs_data_release(data);
@@ -211,10 +1319,19 @@ static void load_settings()
             config.path = obs_data_get_string(item, "path");
             config.shutdown_enabled = obs_data_get_bool(item, "shutdown_enabled");
             config.start_minimized = obs_data_get_bool(item, "start_minimized");
+            config.trigger = job_trigger_from_string(obs_data_get_string(item, "trigger"));
+            config.launch_phase = launch_phase_from_name(obs_data_get_string(item, "launch_phase"));
+            config.launch_delay = (int)obs_data_get_int(item, "launch_delay");
+            obs_data_set_default_int(item, "replicas", 1);
+            config.replicas = (int)obs_data_get_int(item, "replicas");
+            config.in_process = obs_data_get_bool(item, "in_process");
             executable_configs.push_back(config);
             obs_data_release(item);
         }
     }
+    helpers.resize(executable_configs.size());
+    for (HelperRuntime &runtime : helpers)
+        runtime.id = ++last_runtime_id;
     
     obs_data_array_release(array);
     obs_data_release(data);
@@ -246,12 +1363,18 @@ static void save_settings()
         obs_data_set_string(item, "path", config.path.c_str());
         obs_data_set_bool(item, "shutdown_enabled", config.shutdown_enabled);
         obs_data_set_bool(item, "start_minimized", config.start_minimized);
+        obs_data_set_string(item, "trigger", job_trigger_to_string(config.trigger));
+        obs_data_set_string(item, "launch_phase", launch_phase_name(config.launch_phase));
+        obs_data_set_int(item, "launch_delay", config.launch_delay);
+        obs_data_set_int(item, "replicas", config.replicas);
+        obs_data_set_bool(item, "in_process", config.in_process);
         obs_data_array_push_back(array, item);
         obs_data_release(item);
     }
     
     obs_data_set_array(data, "executables", array);
     obs_data_array_release(array);
+    obs_data_set_int(data, "obs_reserved_cores", obs_reserved_cores);
     
     if (!obs_data_save_json_safe(data, config_path, "tmp", "bak")) {
         obs_log(LOG_WARNING, "Failed to save configuration to %s", config_path);
@@ -266,22 +1389,150 @@ static void save_settings()
 // Implementation of functions declared in plugin-support.h
 std::vector<ExecutableConfig> get_executable_configs()
 {
+    std::lock_guard<std::mutex> lock(helpers_mutex);
     return executable_configs;
 }
 
-void update_executable_configs(const std::vector<ExecutableConfig> &configs)
+// Whether a running helper started for a can keep running for b; options that
+// only matter at launch or shutdown are picked up without a restart
+static bool same_helper(const ExecutableConfig &a, const ExecutableConfig &b)
+{
+    return a.path == b.path && a.trigger == b.trigger && a.start_minimized == b.start_minimized &&
+           a.replicas == b.replicas && a.in_process == b.in_process;
+}
+
+void update_executable_configs(const std::vector<ExecutableConfig> &configs, const std::vector<int> &origins)
 {
-    executable_configs = configs;
-    save_settings();
+    // Called from the UI thread: unloading stopped in-process helpers and
+    // restarting edited entries is left to the supervisor
+    {
+        std::lock_guard<std::mutex> lock(helpers_mutex);
+
+        // Entries may have been removed, reordered or edited, so runtimes are
+        // matched by entry rather than by index
+        std::vector<HelperRuntime> matched(configs.size());
+        std::vector<bool> new_matched(configs.size(), false);
+        std::vector<bool> old_matched(helpers.size(), false);
+        // Old entry each new one was edited from, if it has to be restarted
+        std::vector<int> edited_from(configs.size(), -1);
+
+        for (size_t j = 0; j < configs.size() && j < origins.size(); ++j) {
+            int i = origins[j];
+            if (i < 0 || (size_t)i >= helpers.size() || old_matched[i])
+                continue;
+            old_matched[i] = true;
+            if (same_helper(executable_configs[i], configs[j])) {
+                matched[j] = std::move(helpers[i]);
+                new_matched[j] = true;
+            } else {
+                edited_from[j] = i;
+            }
+        }
+        // New entries and callers without origins: keep any identical running entry
+        for (size_t j = 0; j < configs.size(); ++j) {
+            if (new_matched[j] || edited_from[j] >= 0)
+                continue;
+            size_t i = 0;
+            while (i < helpers.size() && (old_matched[i] || !same_helper(executable_configs[i], configs[j])))
+                ++i;
+            if (i < helpers.size()) {
+                matched[j] = std::move(helpers[i]);
+                new_matched[j] = true;
+                old_matched[i] = true;
+            }
+        }
+        for (size_t j = 0; j < configs.size(); ++j) {
+            if (!new_matched[j])
+                matched[j].id = ++last_runtime_id;
+        }
+
+        // Entries that were edited restart with their new settings if they
+        // were running; new entries wait for their launch phase or a START
+        for (size_t j = 0; j < configs.size(); ++j) {
+            int i = edited_from[j];
+            if (i < 0)
+                continue;
+            reap_helper(helpers[i]);
+            bool was_running = helpers[i].wanted || helper_running(helpers[i]);
+            terminate_executable(i, false);
+            matched[j].start_pending = was_running && configs[j].trigger == JobTrigger::None &&
+                                       !configs[j].path.empty();
+        }
+        // Removed entries are stopped
+        for (size_t i = 0; i < helpers.size(); ++i) {
+            if (old_matched[i])
+                continue;
+            reap_helper(helpers[i]);
+            terminate_executable(i, false);
+        }
+
+        executable_configs = configs;
+        helpers.swap(matched);
+        save_settings();
+        wake_supervisor();
+    }
+}
+
+static void update_live_state()
+{
+    job_queue_set_live(obs_frontend_streaming_active() || obs_frontend_recording_active());
+}
+
+// Forwards a frontend event to the running in-process helpers
+static void notify_in_process_helpers(uint32_t type, const char *path)
+{
+    std::lock_guard<std::mutex> lock(helpers_mutex);
+    if (type == OBS_STARTER_HELPER_EVENT_LOADED)
+        obs_finished_loading = true;
+    for (HelperRuntime &runtime : helpers) {
+        if (runtime.in_process)
+            inproc_helper_post_event(runtime.in_process, type, path);
+    }
+}
+
+// Queues jobs for trigger with the file returned by get_path (may be null)
+// and passes the event on to in-process helpers
+static void trigger_jobs(JobTrigger trigger, uint32_t helper_event, char *(*get_path)(void))
+{
+    char *output_path = get_path ? get_path() : nullptr;
+    job_queue_trigger(trigger, output_path);
+    notify_in_process_helpers(helper_event, output_path);
+    bfree(output_path);
 }
 
 static void on_frontend_event(enum obs_frontend_event event, void *private_data)
 {
     switch (event) {
     case OBS_FRONTEND_EVENT_FINISHED_LOADING:
-        start_executables();
+        start_launch_phase(LaunchPhase::AfterLoad);
+        start_launch_phase(LaunchPhase::Idle);
+        update_live_state();
+        notify_in_process_helpers(OBS_STARTER_HELPER_EVENT_LOADED, nullptr);
+        break;
+    case OBS_FRONTEND_EVENT_STREAMING_STARTED:
+        update_live_state();
+        notify_in_process_helpers(OBS_STARTER_HELPER_EVENT_STREAMING_STARTED, nullptr);
+        break;
+    case OBS_FRONTEND_EVENT_RECORDING_STARTED:
+        update_live_state();
+        notify_in_process_helpers(OBS_STARTER_HELPER_EVENT_RECORDING_STARTED, nullptr);
+        break;
+    case OBS_FRONTEND_EVENT_RECORDING_STOPPED:
+        trigger_jobs(JobTrigger::RecordingStopped, OBS_STARTER_HELPER_EVENT_RECORDING_STOPPED,
+                     obs_frontend_get_last_recording);
+        update_live_state();
+        break;
+    case OBS_FRONTEND_EVENT_STREAMING_STOPPED:
+        trigger_jobs(JobTrigger::StreamingStopped, OBS_STARTER_HELPER_EVENT_STREAMING_STOPPED, nullptr);
+        update_live_state();
+        break;
+    case OBS_FRONTEND_EVENT_REPLAY_BUFFER_SAVED:
+        trigger_jobs(JobTrigger::ReplaySaved, OBS_STARTER_HELPER_EVENT_REPLAY_SAVED, obs_frontend_get_last_replay);
         break;
     case OBS_FRONTEND_EVENT_EXIT:
+        prefetch_stop();
+        cancel_launch_phases();
+        job_queue_stop();
         stop_executables();
         break;
     default:
@@ -320,9 +1571,29 @@ bool obs_module_load(void)
 {
     obs_log(LOG_INFO, "OBS Starter plugin loaded successfully (version %s)", PLUGIN_VERSION);
     
+    module_load_ns = os_gettime_ns();
+    
     // Load settings
     load_settings();
     
+    // Warm the page cache for helper binaries and their libraries
+    prefetch_start(get_executable_configs());
+    
+    // Report broken entries now instead of at their first launch
+    preflight_start(get_executable_configs());
+    
+    // Reaps exited helpers and replaces dead replicas
+    start_supervisor();
+    
+    // Helpers that do not depend on OBS start while OBS is still loading
+    start_launch_phase(LaunchPhase::Early);
+    
+    // Serve the local control API
+    control_server_start();
+    
+    // Restore queued jobs, they run once OBS has finished loading
+    job_queue_start();
+    
     // Register frontend events
     obs_frontend_add_event_callback(on_frontend_event, nullptr);
     
@@ -340,6 +1611,12 @@ void obs_module_unload(void)
 {
     obs_log(LOG_INFO, "OBS Starter plugin starting unload...");
     
+    control_server_stop();
+    prefetch_stop();
+    preflight_stop();
+    cancel_launch_phases();
+    job_queue_stop();
+    
     // Stop executables first - this should be safe
     try {
         stop_executables();
@@ -347,6 +1624,7 @@ void obs_module_unload(void)
     } catch (...) {
         obs_log(LOG_ERROR, "Exception while stopping executables");
     }
+    stop_supervisor();
     
     // Don't touch Qt objects at all during shutdown
     // Just set the pointer to nullptr without any Qt calls
@@ -40,14 +40,75 @@ extern void blogva(int log_level, const char *format, va_list args);
 #include <vector>
 #include <string>
 
+// Frontend event that queues an entry as a one-shot job, None for long-running helpers
+enum class JobTrigger {
+    None,
+    RecordingStopped,
+    ReplaySaved,
+    StreamingStopped,
+};
+
+// When a long-running helper is started relative to OBS's own startup
+enum class LaunchPhase {
+    Early,     // during obs_module_load, for helpers that do not need OBS
+    AfterLoad, // once OBS has finished loading
+    Idle,      // once OBS has been idle for launch_delay seconds after loading
+};
+
 struct ExecutableConfig {
     std::string path;
     bool shutdown_enabled;
     bool start_minimized;
+    JobTrigger trigger = JobTrigger::None;
+    LaunchPhase launch_phase = LaunchPhase::AfterLoad;
+    int launch_delay = 0;
+    // Worker processes to run, each with its own shard; 0 sizes the group to the free cores
+    int replicas = 1;
+    // Load path as a helper library (obs-starter-helper.h) on a worker thread instead of starting a process
+    bool in_process = false;
 };
 
 // Function declarations for settings management
 std::vector<ExecutableConfig> get_executable_configs();
-void update_executable_configs(const std::vector<ExecutableConfig> &configs);
+// origins[j] is the index of the current entry that configs[j] was edited
+// from, or -1 for a new entry; without origins entries are matched by identity
+void update_executable_configs(const std::vector<ExecutableConfig> &configs, const std::vector<int> &origins = {});
+
+// Upper bounds (in seconds) of the spawn latency histogram buckets
+constexpr size_t SPAWN_LATENCY_BUCKET_COUNT = 8;
+extern const double spawn_latency_bucket_bounds[SPAWN_LATENCY_BUCKET_COUNT];
+
+// Snapshot of a helper's runtime state, indexed like get_executable_configs()
+struct HelperStatus {
+    size_t index;
+    std::string path;
+    // Running while any replica runs; pid is that of the first running replica
+    bool running;
+    long long pid;
+    unsigned int replicas;
+    std::vector<long long> replica_pids;
+    unsigned int restarts;
+    int last_exit_status;
+    double uptime_seconds;
+    double cpu_seconds;
+    unsigned long long rss_bytes;
+    unsigned long long spawn_latency_buckets[SPAWN_LATENCY_BUCKET_COUNT];
+    unsigned long long spawn_latency_count;
+    double spawn_latency_sum;
+};
+
+enum class HelperControlResult {
+    Ok,
+    NoSuchHelper,
+    AlreadyRunning,
+    NotRunning,
+    SpawnFailed,
+};
+
+// Runtime control of individual helpers; safe to call from any thread
+std::vector<HelperStatus> get_helper_statuses();
+HelperControlResult start_helper(size_t index);
+HelperControlResult stop_helper(size_t index);
+HelperControlResult restart_helper(size_t index);
 
 #endif
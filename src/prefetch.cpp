@@ -0,0 +1,212 @@
+/*
+OBS Starter Plugin - Page Cache Prefetch Implementation
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#include "prefetch.h"
+#include "binary-info.h"
+
+#include <obs-module.h>
+#include <util/platform.h>
+
+#ifdef _WIN32
+
+void prefetch_start(const std::vector<ExecutableConfig> &configs)
+{
+    (void)configs;
+}
+
+void prefetch_stop() {}
+
+#else
+
+#include <atomic>
+#include <deque>
+#include <set>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const size_t MAX_PREFETCH_FILES = 512;
+// Residency of the read-ahead files is re-checked at this interval until all have landed
+static const uint32_t RESIDENT_POLL_MS = 20;
+static const uint64_t RESIDENT_TIMEOUT_NS = 30000000000ULL;
+
+struct ColdFile {
+    std::string path;
+    size_t size;
+};
+
+static std::thread prefetch_thread;
+static std::atomic<bool> prefetch_cancelled{false};
+
+// Collects the files exec of path will touch: interpreters and shared libraries
+static void resolve_dependencies(int fd, const std::string &path, std::vector<std::string> &deps)
+{
+    BinaryInfo info;
+    inspect_binary(fd, path, info);
+
+    if (!info.interpreter.empty())
+        deps.push_back(info.interpreter);
+    if (!info.program_path.empty())
+        deps.push_back(info.program_path);
+    deps.insert(deps.end(), info.libraries.begin(), info.libraries.end());
+}
+
+// Bytes of the mapped file that are not in the page cache yet
+static size_t cold_bytes(int fd, size_t size)
+{
+    void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        return 0;
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t pages = (size + page_size - 1) / page_size;
+#ifdef __APPLE__
+    std::vector<char> residency(pages);
+#else
+    std::vector<unsigned char> residency(pages);
+#endif
+    size_t cold = 0;
+    if (mincore(map, size, residency.data()) == 0) {
+        for (size_t i = 0; i < pages; ++i)
+            cold += (residency[i] & 1) ? 0 : page_size;
+    }
+    munmap(map, size);
+    return cold < size ? cold : size;
+}
+
+// cold_bytes for a file that is no longer open; treated as resident if it is gone
+static size_t cold_bytes_at(const ColdFile &file)
+{
+    int fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    size_t cold = cold_bytes(fd, file.size);
+    close(fd);
+    return cold;
+}
+
+static void advise_willneed(int fd, size_t size)
+{
+#if defined(__linux__)
+    readahead(fd, 0, size);
+#elif defined(__APPLE__)
+    struct radvisory advice = {0, size > INT_MAX ? INT_MAX : (int)size};
+    fcntl(fd, F_RDADVISE, &advice);
+#else
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+}
+
+static void prefetch_thread_main(std::vector<std::string> roots)
+{
+    uint64_t start = os_gettime_ns();
+    std::deque<std::string> queue(roots.begin(), roots.end());
+    std::set<std::string> seen;
+    size_t file_count = 0, total_bytes = 0, total_cold = 0;
+    std::vector<ColdFile> cold_files;
+
+    while (!queue.empty() && !prefetch_cancelled && file_count < MAX_PREFETCH_FILES) {
+        std::string path = queue.front();
+        queue.pop_front();
+
+        char resolved[PATH_MAX];
+        if (!realpath(path.c_str(), resolved) || !seen.insert(resolved).second)
+            continue;
+
+        int fd = open(resolved, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            close(fd);
+            continue;
+        }
+
+        // The readahead is asynchronous and outlives the descriptor, resolving
+        // the next files overlaps with the I/O
+        size_t size = (size_t)st.st_size;
+        size_t cold = cold_bytes(fd, size);
+        if (cold) {
+            advise_willneed(fd, size);
+            cold_files.push_back({resolved, size});
+        }
+        total_bytes += size;
+        total_cold += cold;
+
+        std::vector<std::string> deps;
+        resolve_dependencies(fd, resolved, deps);
+        queue.insert(queue.end(), deps.begin(), deps.end());
+        close(fd);
+        file_count++;
+    }
+
+    uint64_t resolved_ns = os_gettime_ns();
+
+    // The time until the cold bytes are resident is disk time the first launch
+    // no longer waits for; mincore observes it without reading anything itself
+    size_t still_cold = total_cold;
+    while (!cold_files.empty() && !prefetch_cancelled && os_gettime_ns() - resolved_ns < RESIDENT_TIMEOUT_NS) {
+        os_sleep_ms(RESIDENT_POLL_MS);
+        still_cold = 0;
+        for (auto it = cold_files.begin(); it != cold_files.end();) {
+            size_t cold = cold_bytes_at(*it);
+            still_cold += cold;
+            it = cold ? it + 1 : cold_files.erase(it);
+        }
+    }
+    uint64_t resident_ns = os_gettime_ns();
+
+    if (prefetch_cancelled)
+        return;
+
+    obs_log(LOG_INFO, "Prefetch for %zu executables resolved %zu files (%.1f MB) in %.1f ms",
+            roots.size(), file_count, (double)total_bytes / 1048576.0, (double)(resolved_ns - start) / 1e6);
+    if (!total_cold)
+        obs_log(LOG_INFO, "Prefetch found everything in the page cache already");
+    else if (!still_cold)
+        obs_log(LOG_INFO, "Prefetch read ahead %.1f MB of cold files, resident %.1f ms after start (disk time "
+                "taken off the first launch)",
+                (double)total_cold / 1048576.0, (double)(resident_ns - start) / 1e6);
+    else
+        obs_log(LOG_INFO, "Prefetch read ahead %.1f MB of cold files, %.1f MB still not resident after %.1f ms",
+                (double)total_cold / 1048576.0, (double)still_cold / 1048576.0, (double)(resident_ns - start) / 1e6);
+}
+
+void prefetch_start(const std::vector<ExecutableConfig> &configs)
+{
+    if (prefetch_thread.joinable())
+        return;
+
+    std::vector<std::string> roots;
+    for (const ExecutableConfig &config : configs) {
+        if (!config.path.empty())
+            roots.push_back(config.path);
+    }
+    if (roots.empty())
+        return;
+
+    prefetch_cancelled = false;
+    prefetch_thread = std::thread(prefetch_thread_main, roots);
+}
+
+void prefetch_stop()
+{
+    if (!prefetch_thread.joinable())
+        return;
+
+    prefetch_cancelled = true;
+    prefetch_thread.join();
+}
+
+#endif
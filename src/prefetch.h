@@ -0,0 +1,22 @@
+/*
+OBS Starter Plugin - Page Cache Prefetch
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#pragma once
+
+#include <vector>
+#include <plugin-support.h>
+
+// Resolves the executables, their shebang interpreters and shared libraries
+// on a background thread and pulls them into the page cache, so the first
+// exec after boot does not stall on cold disk reads.
+void prefetch_start(const std::vector<ExecutableConfig> &configs);
+
+// Cancels a running prefetch and waits for its thread
+void prefetch_stop();
@@ -0,0 +1,231 @@
+/*
+OBS Starter Plugin - Executable Preflight Checks Implementation
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#include "preflight.h"
+#include "binary-info.h"
+
+#include <obs-module.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+static std::thread preflight_thread;
+
+static PreflightResult failure(const std::string &message)
+{
+    PreflightResult result;
+    result.ok = false;
+    result.message = message;
+    return result;
+}
+
+#ifdef _WIN32
+
+#if defined(_M_ARM64)
+static const WORD HOST_MACHINE = IMAGE_FILE_MACHINE_ARM64;
+#elif defined(_M_X64)
+static const WORD HOST_MACHINE = IMAGE_FILE_MACHINE_AMD64;
+#else
+static const WORD HOST_MACHINE = IMAGE_FILE_MACHINE_I386;
+#endif
+
+static const char *pe_machine_name(WORD machine)
+{
+    switch (machine) {
+    case IMAGE_FILE_MACHINE_I386:
+        return "x86";
+    case IMAGE_FILE_MACHINE_AMD64:
+        return "x86_64";
+    case IMAGE_FILE_MACHINE_ARM64:
+        return "arm64";
+    default:
+        return "an unknown architecture";
+    }
+}
+
+// IMAGE_NT_HEADERS.FileHeader.Machine of the file at path, 0 if it is not a
+// PE image and -1 if it cannot be read
+static int read_pe_machine(const std::string &path)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return -1;
+
+    int machine = 0;
+    IMAGE_DOS_HEADER dos = {};
+    DWORD read = 0;
+    if (ReadFile(file, &dos, sizeof(dos), &read, nullptr) && read == sizeof(dos) &&
+        dos.e_magic == IMAGE_DOS_SIGNATURE && dos.e_lfanew > 0) {
+        LARGE_INTEGER offset;
+        offset.QuadPart = dos.e_lfanew;
+        DWORD signature = 0;
+        IMAGE_FILE_HEADER header = {};
+        if (SetFilePointerEx(file, offset, nullptr, FILE_BEGIN) &&
+            ReadFile(file, &signature, sizeof(signature), &read, nullptr) && read == sizeof(signature) &&
+            signature == IMAGE_NT_SIGNATURE && ReadFile(file, &header, sizeof(header), &read, nullptr) &&
+            read == sizeof(header))
+            machine = header.Machine;
+    }
+    CloseHandle(file);
+    return machine;
+}
+
+PreflightResult preflight_check(const ExecutableConfig &config)
+{
+    if (config.path.empty())
+        return PreflightResult();
+
+    DWORD attributes = GetFileAttributesA(config.path.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES)
+        return failure("Not found");
+    if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+        return failure(config.in_process ? "Is a directory, not a helper library" : "Is a directory, not an executable");
+
+    int machine = read_pe_machine(config.path);
+    if (machine < 0)
+        return failure("Not readable");
+
+    PreflightResult result;
+    if (machine == 0) {
+        if (config.in_process)
+            return failure("Not a DLL");
+        // Batch files and the like are still started by CreateProcess
+        result.message = "OK, unrecognized format";
+        return result;
+    }
+
+    // A library must match OBS itself; processes may also run under WOW64
+    // or, on arm64, under x64 emulation
+    bool runnable = machine == HOST_MACHINE;
+    if (!config.in_process) {
+        runnable = runnable || machine == IMAGE_FILE_MACHINE_I386 ||
+                   (HOST_MACHINE == IMAGE_FILE_MACHINE_ARM64 && machine == IMAGE_FILE_MACHINE_AMD64);
+    }
+    if (!runnable)
+        return failure(std::string("Built for ") + pe_machine_name((WORD)machine) + ", not for this machine");
+
+    result.message = std::string("OK, ") + pe_machine_name((WORD)machine);
+    return result;
+}
+
+#else
+
+static bool is_executable_file(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(path.c_str(), X_OK) == 0;
+}
+
+PreflightResult preflight_check(const ExecutableConfig &config)
+{
+    if (config.path.empty())
+        return PreflightResult();
+
+    struct stat st;
+    if (stat(config.path.c_str(), &st) != 0)
+        return failure("Not found");
+    if (!S_ISREG(st.st_mode))
+        return failure(S_ISDIR(st.st_mode) ? (config.in_process ? "Is a directory, not a helper library"
+                                                                 : "Is a directory, not an executable")
+                                           : "Not a regular file");
+    // Helper libraries are loaded, not executed, and need no execute permission
+    if (!config.in_process && access(config.path.c_str(), X_OK) != 0)
+        return failure("Not executable (missing execute permission)");
+
+    int fd = open(config.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return failure("Not readable");
+    BinaryInfo info;
+    inspect_binary(fd, config.path, info);
+    close(fd);
+
+    PreflightResult result;
+    if (config.in_process && info.is_script)
+        return failure("Is a script, not a shared library");
+    if (info.is_script) {
+        if (info.interpreter.empty())
+            return failure("Empty #! line");
+        if (!is_executable_file(info.interpreter))
+            return failure("Interpreter not found: " + info.interpreter);
+        if (!info.program.empty() && info.program_path.empty())
+            return failure("'" + info.program + "' not found in PATH");
+        result.message = "OK, script run by " + (info.program_path.empty() ? info.interpreter : info.program_path);
+    } else if (info.is_native) {
+        if (!info.arch_matches)
+            return failure("Built for " + info.arch + ", not for this machine");
+        if (!info.interpreter.empty() && access(info.interpreter.c_str(), X_OK) != 0)
+            return failure("Program interpreter not found: " + info.interpreter);
+        if (!info.missing_libraries.empty()) {
+            std::string missing;
+            for (const std::string &library : info.missing_libraries)
+                missing += (missing.empty() ? "" : ", ") + library;
+            return failure("Missing libraries: " + missing);
+        }
+        result.message = "OK, " + info.arch;
+        if (!info.libraries.empty())
+            result.message += ", " + std::to_string(info.libraries.size()) + " libraries";
+    } else {
+        // Might still run through binfmt_misc, so only mention it
+        result.message = "OK, unrecognized format";
+    }
+    return result;
+}
+
+#endif
+
+std::vector<PreflightResult> preflight_check_all(const std::vector<ExecutableConfig> &configs)
+{
+    std::vector<PreflightResult> results(configs.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < configs.size(); i = next++)
+            results[i] = preflight_check(configs[i]);
+    };
+
+    // Checks are dominated by file system latency, so a few threads help even on small machines
+    size_t thread_count = std::min<size_t>(configs.size(), std::max(4u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread &thread : threads)
+        thread.join();
+    return results;
+}
+
+void preflight_start(const std::vector<ExecutableConfig> &configs)
+{
+    if (preflight_thread.joinable() || configs.empty())
+        return;
+
+    preflight_thread = std::thread([configs]() {
+        std::vector<PreflightResult> results = preflight_check_all(configs);
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (!results[i].ok)
+                obs_log(LOG_WARNING, "Preflight failed for %s: %s", configs[i].path.c_str(),
+                        results[i].message.c_str());
+        }
+    });
+}
+
+void preflight_stop()
+{
+    if (preflight_thread.joinable())
+        preflight_thread.join();
+}
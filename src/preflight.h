@@ -0,0 +1,32 @@
+/*
+OBS Starter Plugin - Executable Preflight Checks
+Copyright (C) 2024
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <plugin-support.h>
+
+struct PreflightResult {
+    bool ok = true;
+    // First problem found, or a short description of what will be run
+    std::string message;
+};
+
+// Checks that an entry can actually be exec'd: existence, exec bit,
+// architecture, shebang interpreter and shared libraries
+PreflightResult preflight_check(const ExecutableConfig &config);
+
+// Checks all entries concurrently on a bounded pool, blocks until done
+std::vector<PreflightResult> preflight_check_all(const std::vector<ExecutableConfig> &configs);
+
+// Runs preflight_check_all() in the background and logs the failures
+void preflight_start(const std::vector<ExecutableConfig> &configs);
+void preflight_stop();